@@ -0,0 +1,489 @@
+#include "srg/sim/ContainerUtils.h"
+#include "srg/sim/PathPlanner.h"
+#include "srg/sim/PerceptionApplier.h"
+#include "srg/sim/SimulatedAgent.h"
+#include "srg/sim/communication/MessageArena.h"
+#include "srg/sim/containers/PathQuery.h"
+#include "srg/sim/containers/Perceptions.h"
+
+#include <srg/World.h>
+#include <srg/world/Agent.h>
+#include <srg/world/BuildingGenerator.h>
+#include <srg/world/Cell.h>
+#include <srg/world/Object.h>
+#include <srg/world/Scenario.h>
+
+#include <essentials/IDManager.h>
+
+#include <benchmark/benchmark.h>
+#include <capnp/message.h>
+#include <capnp/serialize.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+/**
+ * Microbenchmarks for the hot paths of the simulator.
+ *
+ * Usage: grid_sim_bench [--map=<file.tmx>] [google benchmark flags]
+ * Without --map a synthetic office map is generated. For machine-readable
+ * results pass --benchmark_out=<file> --benchmark_out_format=json.
+ */
+namespace
+{
+const uint32_t SYNTHETIC_SIZE_X = 128;
+const uint32_t SYNTHETIC_SIZE_Y = 64;
+const uint32_t SYNTHETIC_ROOM_SIZE = 10;
+const int32_t AGENT_ID = 100000;
+const int32_t FIRST_CUP_ID = 200000;
+const int32_t CUP_COUNT = 200;
+const int32_t CHECK_CUP_ID = 300000;
+const uint32_t PATH_QUERY_COUNT = 300;
+const uint32_t PATH_MAX_EXPANSIONS = 10000000;
+const uint32_t PATH_HIERARCHICAL_DISTANCE = 64;
+
+std::string mapFile;
+
+/**
+ * Writes a TMX map with an outer wall and a grid of offices, which are
+ * separated by walls with an opening to the next office on each side.
+ */
+std::string writeSyntheticMap()
+{
+    const uint32_t wallGid = 17 + static_cast<uint32_t>(srg::world::RoomType::Wall);
+    const uint32_t officeGid = 17 + static_cast<uint32_t>(srg::world::RoomType::Office);
+    const uint32_t cellsPerRoom = SYNTHETIC_ROOM_SIZE + 1;
+
+    std::vector<std::vector<uint32_t>> layers;
+    std::vector<uint32_t> walls(SYNTHETIC_SIZE_X * SYNTHETIC_SIZE_Y, 0);
+    for (uint32_t roomX = 0; roomX * cellsPerRoom + 1 < SYNTHETIC_SIZE_X - 1; roomX++) {
+        for (uint32_t roomY = 0; roomY * cellsPerRoom + 1 < SYNTHETIC_SIZE_Y - 1; roomY++) {
+            layers.push_back(std::vector<uint32_t>(SYNTHETIC_SIZE_X * SYNTHETIC_SIZE_Y, 0));
+        }
+    }
+
+    uint32_t roomsY = (SYNTHETIC_SIZE_Y - 2) / cellsPerRoom + ((SYNTHETIC_SIZE_Y - 2) % cellsPerRoom > 0 ? 1 : 0);
+    for (uint32_t x = 0; x < SYNTHETIC_SIZE_X; x++) {
+        for (uint32_t y = 0; y < SYNTHETIC_SIZE_Y; y++) {
+            bool border = x == 0 || y == 0 || x == SYNTHETIC_SIZE_X - 1 || y == SYNTHETIC_SIZE_Y - 1;
+            bool separatorX = x % cellsPerRoom == 0;
+            bool separatorY = y % cellsPerRoom == 0;
+            bool opening = (separatorX && y % cellsPerRoom == cellsPerRoom / 2) || (separatorY && x % cellsPerRoom == cellsPerRoom / 2);
+            if (border || ((separatorX || separatorY) && !opening)) {
+                walls[y * SYNTHETIC_SIZE_X + x] = wallGid;
+            } else {
+                uint32_t room = (std::max(x, 1u) - 1) / cellsPerRoom * roomsY + (std::max(y, 1u) - 1) / cellsPerRoom;
+                layers[room][y * SYNTHETIC_SIZE_X + x] = officeGid;
+            }
+        }
+    }
+    layers.push_back(walls);
+
+    std::string file = "/tmp/grid_sim_bench_map.tmx";
+    std::ofstream os(file, std::ios::trunc);
+    os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+       << "<map version=\"1.0\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\"" << SYNTHETIC_SIZE_X << "\" height=\""
+       << SYNTHETIC_SIZE_Y << "\" tilewidth=\"60\" tileheight=\"60\" nextobjectid=\"1\">\n"
+       << " <tileset firstgid=\"1\" name=\"textures\" tilewidth=\"60\" tileheight=\"60\" tilecount=\"16\" columns=\"4\">\n"
+       << "  <image source=\"textures.png\" width=\"240\" height=\"240\"/>\n"
+       << " </tileset>\n"
+       << " <tileset firstgid=\"17\" name=\"roomtypes\" tilewidth=\"60\" tileheight=\"60\" tilecount=\"12\" columns=\"4\">\n"
+       << "  <image source=\"textures.png\" width=\"240\" height=\"240\"/>\n"
+       << " </tileset>\n";
+    for (size_t i = 0; i < layers.size(); i++) {
+        os << " <layer name=\"" << (i + 1 == layers.size() ? std::string("Walls") : "Office" + std::to_string(i)) << "\" width=\""
+           << SYNTHETIC_SIZE_X << "\" height=\"" << SYNTHETIC_SIZE_Y << "\">\n"
+           << "  <properties>\n   <property name=\"ID\" type=\"int\" value=\"" << (i + 1) << "\"/>\n  </properties>\n"
+           << "  <data encoding=\"csv\">\n";
+        for (uint32_t y = 0; y < SYNTHETIC_SIZE_Y; y++) {
+            for (uint32_t x = 0; x < SYNTHETIC_SIZE_X; x++) {
+                os << layers[i][y * SYNTHETIC_SIZE_X + x];
+                if (x + 1 < SYNTHETIC_SIZE_X || y + 1 < SYNTHETIC_SIZE_Y) {
+                    os << ",";
+                }
+            }
+            os << "\n";
+        }
+        os << "</data>\n </layer>\n";
+    }
+    os << "</map>\n";
+    return file;
+}
+
+/**
+ * Shared fixture state: the world is loaded once and reused by all benchmarks.
+ */
+struct BenchWorld
+{
+    BenchWorld()
+            : world(mapFile, idManager)
+            , random(42)
+    {
+        // free cells for objects and the agent
+        for (auto& entry : world.getGrid()) {
+            if (entry.second->getType() != srg::world::RoomType::Wall) {
+                freeCells.push_back(entry.first);
+            }
+        }
+
+        std::uniform_int_distribution<size_t> cellDistribution(0, freeCells.size() - 1);
+        for (int32_t i = 0; i < CUP_COUNT; i++) {
+            auto cup = world.createOrUpdateObject(std::make_shared<srg::world::Object>(
+                    idManager.getID<int32_t>(FIRST_CUP_ID + i), static_cast<srg::world::ObjectType>(1 + i % 3)));
+            world.placeObject(cup, freeCells[cellDistribution(random)]);
+            cups.push_back(cup);
+        }
+
+        // place the agent in the middle of the map, on a cell it can leave to the left
+        std::shared_ptr<srg::world::Object> object =
+                world.createOrUpdateObject(std::make_shared<srg::world::Object>(idManager.getID<int32_t>(AGENT_ID), srg::world::ObjectType::Robot));
+        agent = std::dynamic_pointer_cast<srg::world::Agent>(object);
+        for (size_t i = freeCells.size() / 2; i < freeCells.size(); i++) {
+            std::shared_ptr<const srg::world::Cell> cell = world.getCell(freeCells[i]);
+            if (cell->left && !cell->left->isBlocked() && world.placeObject(agent, freeCells[i])) {
+                break;
+            }
+        }
+        world.addAgent(agent);
+    }
+
+    essentials::IDManager idManager;
+    srg::World world;
+    std::mt19937 random;
+    std::vector<srg::world::Coordinate> freeCells;
+    std::vector<std::shared_ptr<srg::world::Object>> cups;
+    std::shared_ptr<srg::world::Agent> agent;
+};
+
+BenchWorld& getBenchWorld()
+{
+    static BenchWorld benchWorld;
+    return benchWorld;
+}
+
+void BM_WorldGetCell(benchmark::State& state)
+{
+    BenchWorld& bw = getBenchWorld();
+    std::vector<srg::world::Coordinate> coordinates;
+    std::uniform_int_distribution<int32_t> xDistribution(0, bw.world.getSizeX() - 1);
+    std::uniform_int_distribution<int32_t> yDistribution(0, bw.world.getSizeY() - 1);
+    for (int i = 0; i < 1024; i++) {
+        coordinates.push_back(srg::world::Coordinate(xDistribution(bw.random), yDistribution(bw.random)));
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bw.world.getCell(coordinates[i++ & 1023]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WorldGetCell);
+
+void BM_WorldMoveObject(benchmark::State& state)
+{
+    BenchWorld& bw = getBenchWorld();
+    bool left = true;
+    for (auto _ : state) {
+        bw.world.moveObject(bw.agent->getID(), left ? srg::world::Direction::Left : srg::world::Direction::Right);
+        left = !left;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WorldMoveObject);
+
+void BM_SensorCreatePerceptions(benchmark::State& state)
+{
+    BenchWorld& bw = getBenchWorld();
+    srg::sim::SimulatedAgent simulatedAgent(bw.agent, static_cast<uint32_t>(state.range(0)));
+    size_t cells = 0;
+    for (auto _ : state) {
+        srg::sim::containers::Perceptions perceptions = simulatedAgent.createSimPerceptions(&bw.world);
+        cells = perceptions.cellPerceptions.size();
+        benchmark::DoNotOptimize(perceptions);
+    }
+    state.counters["cells"] = cells;
+}
+BENCHMARK(BM_SensorCreatePerceptions)->Arg(5)->Arg(10)->Arg(20)->Arg(40);
+
+void BM_PerceptionsRoundTrip(benchmark::State& state)
+{
+    BenchWorld& bw = getBenchWorld();
+    srg::sim::SimulatedAgent simulatedAgent(bw.agent, static_cast<uint32_t>(state.range(0)));
+    srg::sim::containers::Perceptions perceptions = simulatedAgent.createSimPerceptions(&bw.world);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        ::capnp::MallocMessageBuilder msgBuilder;
+        srg::sim::ContainerUtils::toMsg(perceptions, msgBuilder);
+        kj::Array<capnp::word> wordArray = capnp::messageToFlatArray(msgBuilder);
+        bytes = wordArray.asBytes().size();
+        ::capnp::FlatArrayMessageReader reader(wordArray);
+        benchmark::DoNotOptimize(srg::sim::ContainerUtils::toPerceptions(reader, bw.idManager));
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.counters["bytes"] = bytes;
+}
+BENCHMARK(BM_PerceptionsRoundTrip)->Arg(5)->Arg(10)->Arg(20);
+
+void BM_PerceptionsDirectEncoding(benchmark::State& state)
+{
+    BenchWorld& bw = getBenchWorld();
+    srg::sim::SimulatedAgent simulatedAgent(bw.agent, static_cast<uint32_t>(state.range(0)));
+    srg::sim::communication::MessageArena arena;
+    for (auto _ : state) {
+        ::capnp::MallocMessageBuilder msgBuilder(arena.getFirstSegment());
+        srg::sim::PerceptionMsg::Builder msg = msgBuilder.initRoot<srg::sim::PerceptionMsg>();
+        srg::sim::ContainerUtils::toMsg(
+                bw.agent->getID(), std::chrono::system_clock::now().time_since_epoch(), simulatedAgent.collectVisibleCells(&bw.world), msg);
+        arena.recycle(msgBuilder);
+    }
+}
+BENCHMARK(BM_PerceptionsDirectEncoding)->Arg(5)->Arg(10)->Arg(20);
+
+/**
+ * Encodes cells of a window with objects in several columns and rows into the compact message and checks
+ * that every object is decoded again. The cells are passed ordered by x, like the sensor collects them.
+ */
+bool checkCompactRoundTrip(BenchWorld& bw)
+{
+    srg::World checkWorld(mapFile, bw.idManager);
+    srg::world::Coordinate center = bw.freeCells[bw.freeCells.size() / 2];
+    std::vector<const srg::world::Cell*> cells;
+    size_t placed = 0;
+    for (auto& entry : checkWorld.getGrid()) {
+        if (std::abs(entry.first.x - center.x) > 4 || std::abs(entry.first.y - center.y) > 4) {
+            continue;
+        }
+        cells.push_back(entry.second.get());
+        if (entry.second->getType() != srg::world::RoomType::Wall && (entry.first.x + entry.first.y) % 3 == 0) {
+            auto cup = checkWorld.createOrUpdateObject(std::make_shared<srg::world::Object>(
+                    bw.idManager.getID<int32_t>(CHECK_CUP_ID + static_cast<int32_t>(placed)), srg::world::ObjectType::CupBlue));
+            if (checkWorld.placeObject(cup, entry.first)) {
+                placed++;
+            }
+        }
+    }
+
+    ::capnp::MallocMessageBuilder msgBuilder;
+    srg::sim::CompactPerceptionMsg::Builder msg = msgBuilder.initRoot<srg::sim::CompactPerceptionMsg>();
+    srg::sim::ContainerUtils::toMsg(bw.agent->getID(), std::chrono::system_clock::now().time_since_epoch(), cells, msg);
+    kj::Array<capnp::word> wordArray = capnp::messageToFlatArray(msgBuilder);
+    ::capnp::FlatArrayMessageReader reader(wordArray);
+    srg::sim::containers::Perceptions perceptions = srg::sim::ContainerUtils::toCompactPerceptions(reader, bw.idManager);
+    size_t decoded = 0;
+    for (auto& cellPerception : perceptions.cellPerceptions) {
+        decoded += cellPerception.objects.size();
+    }
+    return placed > 0 && decoded == placed && perceptions.cellPerceptions.size() == cells.size();
+}
+
+void BM_CompactPerceptionsRoundTrip(benchmark::State& state)
+{
+    BenchWorld& bw = getBenchWorld();
+    if (!checkCompactRoundTrip(bw)) {
+        state.SkipWithError("compact perceptions lost objects in the round trip");
+        return;
+    }
+    srg::sim::SimulatedAgent simulatedAgent(bw.agent, static_cast<uint32_t>(state.range(0)));
+    const std::vector<const srg::world::Cell*>& cells = simulatedAgent.collectVisibleCells(&bw.world);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        ::capnp::MallocMessageBuilder msgBuilder;
+        srg::sim::CompactPerceptionMsg::Builder msg = msgBuilder.initRoot<srg::sim::CompactPerceptionMsg>();
+        srg::sim::ContainerUtils::toMsg(bw.agent->getID(), std::chrono::system_clock::now().time_since_epoch(), cells, msg);
+        kj::Array<capnp::word> wordArray = capnp::messageToFlatArray(msgBuilder);
+        bytes = wordArray.asBytes().size();
+        ::capnp::FlatArrayMessageReader reader(wordArray);
+        benchmark::DoNotOptimize(srg::sim::ContainerUtils::toCompactPerceptions(reader, bw.idManager));
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.counters["bytes"] = bytes;
+}
+BENCHMARK(BM_CompactPerceptionsRoundTrip)->Arg(5)->Arg(10)->Arg(20);
+
+/**
+ * Encodes the perceptions of the bench agent once, for the client side benchmarks.
+ */
+kj::Array<capnp::word> encodePerceptions(BenchWorld& bw, uint32_t sightLimit)
+{
+    srg::sim::SimulatedAgent simulatedAgent(bw.agent, sightLimit);
+    ::capnp::MallocMessageBuilder msgBuilder;
+    srg::sim::PerceptionMsg::Builder msg = msgBuilder.initRoot<srg::sim::PerceptionMsg>();
+    srg::sim::ContainerUtils::toMsg(bw.agent->getID(), std::chrono::system_clock::now().time_since_epoch(), simulatedAgent.collectVisibleCells(&bw.world), msg);
+    return capnp::messageToFlatArray(msgBuilder);
+}
+
+void BM_PerceptionsApplyContainers(benchmark::State& state)
+{
+    BenchWorld& bw = getBenchWorld();
+    srg::World clientWorld(mapFile, bw.idManager);
+    kj::Array<capnp::word> wordArray = encodePerceptions(bw, static_cast<uint32_t>(state.range(0)));
+    for (auto _ : state) {
+        ::capnp::FlatArrayMessageReader reader(wordArray);
+        srg::sim::containers::Perceptions perceptions = srg::sim::ContainerUtils::toPerceptions(reader, bw.idManager);
+        for (srg::sim::containers::CellPerception& cellPerception : perceptions.cellPerceptions) {
+            std::vector<std::shared_ptr<srg::world::Object>> objects;
+            for (std::shared_ptr<srg::world::Object>& object : cellPerception.objects) {
+                objects.push_back(clientWorld.createOrUpdateObject(object));
+            }
+            clientWorld.updateCell(srg::world::Coordinate(cellPerception.x, cellPerception.y), objects, cellPerception.time);
+        }
+    }
+}
+BENCHMARK(BM_PerceptionsApplyContainers)->Arg(5)->Arg(10)->Arg(20);
+
+void BM_PerceptionsApplyInPlace(benchmark::State& state)
+{
+    BenchWorld& bw = getBenchWorld();
+    srg::World clientWorld(mapFile, bw.idManager);
+    srg::sim::PerceptionApplier applier(clientWorld, bw.idManager);
+    kj::Array<capnp::word> wordArray = encodePerceptions(bw, static_cast<uint32_t>(state.range(0)));
+    for (auto _ : state) {
+        ::capnp::FlatArrayMessageReader reader(wordArray);
+        applier.apply(reader);
+    }
+}
+BENCHMARK(BM_PerceptionsApplyInPlace)->Arg(5)->Arg(10)->Arg(20);
+
+void BM_ObjectSetUpdate(benchmark::State& state)
+{
+    BenchWorld& bw = getBenchWorld();
+    // a cell of a world of its own and objects that are not part of any world, so the shared fixture stays untouched
+    srg::World cellWorld(mapFile, bw.idManager);
+    std::shared_ptr<srg::world::Cell> cell = cellWorld.editCell(bw.freeCells.front());
+    size_t objectCount = static_cast<size_t>(state.range(0));
+    std::vector<std::shared_ptr<srg::world::Object>> objects;
+    for (size_t i = 0; i < objectCount + objectCount / 2; i++) {
+        objects.push_back(std::make_shared<srg::world::Object>(
+                bw.idManager.getID<int32_t>(FIRST_CUP_ID + CUP_COUNT + static_cast<int32_t>(i)), srg::world::ObjectType::CupRed));
+    }
+    std::vector<std::shared_ptr<srg::world::Object>> first(objects.begin(), objects.begin() + objectCount);
+    std::vector<std::shared_ptr<srg::world::Object>> second(objects.begin() + objectCount / 2, objects.end());
+    bool toggle = true;
+    for (auto _ : state) {
+        cell->update(toggle ? first : second);
+        toggle = !toggle;
+    }
+    state.SetItemsProcessed(state.iterations() * objectCount);
+}
+BENCHMARK(BM_ObjectSetUpdate)->Arg(1)->Arg(4)->Arg(16);
+/**
+ * Generated office building with 8 wings, its doors and cups, and random path queries between free cells.
+ * Both planners see the same world, one searches every query on the grid, the other long ones over the room graph.
+ */
+struct BenchBuilding
+{
+    BenchBuilding()
+            : world(writeBuilding(), idManager)
+            , flatPlanner(&world, PATH_MAX_EXPANSIONS, 0)
+            , hierarchicalPlanner(&world, PATH_MAX_EXPANSIONS, PATH_HIERARCHICAL_DISTANCE)
+    {
+        srg::world::Scenario scenario;
+        scenario.load(scenarioFile());
+        uint32_t deferred;
+        world.placeObjects(scenario.getObjects(), idManager, deferred);
+        flatPlanner.update();
+        hierarchicalPlanner.update();
+
+        std::mt19937 random(1);
+        for (uint32_t i = 0; i < PATH_QUERY_COUNT; i++) {
+            srg::sim::containers::PathQuery query{i, nullptr, random() % world.getSizeX(), random() % world.getSizeY(), random() % world.getSizeX(),
+                    random() % world.getSizeY(), 0, {}};
+            srg::sim::containers::PathResult result = flatPlanner.findPath(query);
+            if (result.status != srg::sim::containers::PathResult::Status::Invalid) {
+                queries.push_back(query);
+                statuses.push_back(result.status);
+            }
+        }
+    }
+
+    static std::string scenarioFile()
+    {
+        return "/tmp/grid_sim_bench_building.csv";
+    }
+
+    static std::string writeBuilding()
+    {
+        srg::world::BuildingParameters parameters;
+        parameters.seed = 3;
+        parameters.wings = 8;
+        parameters.roomsPerRow = 40;
+        parameters.cups = 100;
+        srg::world::BuildingGenerator generator(parameters);
+        std::string file = "/tmp/grid_sim_bench_building.srgmap";
+        if (!generator.generate() || !generator.writeMap(file) || !generator.writeScenario(scenarioFile())) {
+            std::cerr << "[GridSimBench] Unable to write the generated building!" << std::endl;
+        }
+        return file;
+    }
+
+    essentials::IDManager idManager;
+    srg::World world;
+    srg::sim::PathPlanner flatPlanner;
+    srg::sim::PathPlanner hierarchicalPlanner;
+    std::vector<srg::sim::containers::PathQuery> queries;
+    std::vector<srg::sim::containers::PathResult::Status> statuses; /**< Of the flat search. */
+};
+
+BenchBuilding& getBenchBuilding()
+{
+    static BenchBuilding benchBuilding;
+    return benchBuilding;
+}
+
+/**
+ * Answers all queries with flat A* (0) or over the room graph (1). The hierarchical search has to give the same
+ * status for every query as the flat one.
+ */
+void BM_PathQuery(benchmark::State& state)
+{
+    BenchBuilding& bb = getBenchBuilding();
+    bool hierarchical = state.range(0) != 0;
+    srg::sim::PathPlanner& planner = hierarchical ? bb.hierarchicalPlanner : bb.flatPlanner;
+    for (size_t i = 0; i < bb.queries.size(); i++) {
+        if (planner.findPath(bb.queries[i]).status != bb.statuses[i]) {
+            state.SkipWithError("hierarchical and flat search disagree");
+            return;
+        }
+    }
+
+    uint64_t expansions = 0;
+    for (auto _ : state) {
+        expansions = 0;
+        for (const srg::sim::containers::PathQuery& query : bb.queries) {
+            srg::sim::containers::PathResult result = planner.findPath(query);
+            expansions += result.expansions;
+            benchmark::DoNotOptimize(result);
+        }
+    }
+    state.SetLabel(hierarchical ? "hierarchical" : "flat");
+    state.SetItemsProcessed(state.iterations() * bb.queries.size());
+    state.counters["queries"] = bb.queries.size();
+    state.counters["expansions"] = expansions;
+}
+BENCHMARK(BM_PathQuery)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+} // namespace
+
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv);
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg.compare(0, 6, "--map=") == 0) {
+            mapFile = arg.substr(6);
+        } else {
+            std::cerr << "[GridSimBench] Unknown argument '" << arg << "'" << std::endl;
+            return 1;
+        }
+    }
+    if (mapFile.empty()) {
+        mapFile = writeSyntheticMap();
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
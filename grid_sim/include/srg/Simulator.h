@@ -1,10 +1,12 @@
 #pragma once
 
 #include "srg/sim/SimulatedAgent.h"
+#include "srg/sim/containers/PathQuery.h"
 #include "srg/sim/containers/SimCommand.h"
 
 #include <essentials/IdentifierConstPtr.h>
 
+#include <chrono>
 #include <mutex>
 #include <deque>
 #include <srg/viz/Marker.h>
@@ -28,11 +30,18 @@ namespace sim
 namespace communication
 {
 class Communication;
+class Transport;
 }
 namespace commands
 {
 class CommandHandler;
 }
+namespace profiling
+{
+class TickProfiler;
+}
+class CheckpointWriter;
+class PathPlanner;
 } // namespace sim
 
 namespace world
@@ -40,33 +49,87 @@ namespace world
 class Object;
 class Cell;
 } // namespace world
+namespace viz
+{
+class Recorder;
+class SnapshotBuilder;
+struct WorldSnapshot;
+} // namespace viz
 
 class World;
 class GUI;
 class Simulator
 {
 public:
-    Simulator(bool headless = false);
+    /**
+     * @param transport Transport to the agents instead of the configured one, e.g., a LoopbackTransport for running in-process.
+     */
+    Simulator(bool headless = false, sim::communication::Transport* transport = nullptr);
     ~Simulator();
     void start();
     void run();
+    /**
+     * Executes one iteration without waiting, for driving the simulator without its own thread.
+     */
+    void step();
+    /**
+     * Debug markers are shown for their lifetime, the marker methods can be called from any thread.
+     */
     void addMarker(viz::Marker marker);
+    void addMarkers(std::vector<viz::Marker> markers);
+    void removeMarker(uint64_t id);
     srg::World* getWorld();
+    sim::profiling::TickProfiler* getProfiler();
+    sim::communication::Transport* getTransport();
     void addSimulatedAgent(std::shared_ptr<world::Agent> agent);
+    /**
+     * Stops sending perceptions to the agent, e.g., after it disconnected, and frees its message arenas.
+     * Its object stays in the world. Has to be called by the simulator thread, e.g., from a command handler.
+     */
+    void removeSimulatedAgent(essentials::IdentifierConstPtr id);
     sim::SimulatedAgent* getAgent(essentials::IdentifierConstPtr id);
     static bool isRunning();
     static void simSigintHandler(int sig);
     void processSimCommand(sim::containers::SimCommand sc);
+    void processSimCommands(const std::vector<sim::containers::SimCommand>& simCommands);
+    /**
+     * Restores objects, agents, the random engine and the iteration from a checkpoint, before start().
+     */
+    bool restore(const std::string& checkpointFile);
+    uint64_t getTick() const;
+    /**
+     * Searches a path on the passability of the last iteration, walls and closed doors are blocked.
+     * Can be called from any thread, the latency is recorded in the pathQuery histogram.
+     */
+    sim::containers::PathResult findPath(const sim::containers::PathQuery& query) const;
+    sim::PathPlanner* getPathPlanner();
 
 private:
     void placeObjectsFromConf();
+    void placeObjectsFromScenario(const std::string& scenarioFile);
+    void createRecorderFromConf();
+    void createCheckpointWriterFromConf();
+    void writeCheckpoint();
+    void publishSnapshot();
+    void enqueueSimCommand(const sim::containers::SimCommand& sc);
 
     essentials::SystemConfig& sc;
     static bool running;
     bool headless;
     World* world;
     GUI* gui;
+    viz::SnapshotBuilder* snapshotBuilder;
+    viz::WorldSnapshot* snapshot;
+    viz::Recorder* recorder;
+    uint32_t recordingInterval;
+    std::chrono::steady_clock::duration lastTickDuration;
+    uint32_t chunkActivationRange; /**< Chunks within this range of an agent are active. */
+    uint64_t tick;
+    sim::CheckpointWriter* checkpointWriter;
+    uint32_t checkpointInterval;
+    sim::PathPlanner* pathPlanner;
     sim::communication::Communication* communication;
+    sim::profiling::TickProfiler* profiler;
     std::vector<sim::SimulatedAgent*> simulatedAgents;
 
     essentials::IDManager* idManager;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <srg/world/Checkpoint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace srg
+{
+namespace sim
+{
+/**
+ * Writes checkpoints in a background thread, so the simulator only pays for copying the state.
+ * If a checkpoint is still being written, a newer one replaces the waiting one.
+ */
+class CheckpointWriter
+{
+public:
+    CheckpointWriter(std::string directory);
+    /**
+     * Writes the waiting checkpoint before returning.
+     */
+    ~CheckpointWriter();
+
+    /**
+     * Takes over the checkpoint, which is written to <directory>/checkpoint_<tick>.srgcp.
+     */
+    void write(world::Checkpoint* checkpoint);
+    uint64_t getWrittenCheckpoints() const;
+    uint64_t getDroppedCheckpoints() const;
+
+private:
+    void writeLoop();
+
+    std::string directory;
+    world::Checkpoint* waiting;
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    std::atomic<bool> running;
+    std::atomic<uint64_t> writtenCheckpoints;
+    std::atomic<uint64_t> droppedCheckpoints;
+    std::thread* writerThread;
+};
+} // namespace sim
+} // namespace srg
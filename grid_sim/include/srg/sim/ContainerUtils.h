@@ -1,9 +1,15 @@
 #pragma once
 
+#include "srg/sim/containers/PathQuery.h"
 #include "srg/sim/containers/SimCommand.h"
 #include "srg/sim/containers/Perceptions.h"
 
+#include <srg/sim/msgs/CompactPerceptionMsg.capnp.h>
+#include <srg/sim/msgs/IDMappingMsg.capnp.h>
+#include <srg/sim/msgs/PathQueryMsg.capnp.h>
 #include <srg/sim/msgs/PerceptionMsg.capnp.h>
+#include <srg/sim/msgs/SimCommandMsg.capnp.h>
+#include <srg/sim/msgs/WorldDeltaMsg.capnp.h>
 
 #include <capnzero/CapnZero.h>
 
@@ -14,26 +20,89 @@ class IDManager;
 
 namespace srg
 {
+namespace world
+{
+class Cell;
+}
 namespace sim
 {
+class IDHandleRegistry;
+
+/**
+ * All conversions take an optional IDHandleRegistry. If given, IDs are written as dense handles,
+ * the simulator assigns them while encoding, clients resolve them from the announced IDMappingMsgs.
+ */
 class ContainerUtils
 {
 public:
-    static containers::SimCommand toSimCommand(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager);
-    static void toMsg(containers::SimCommand simCommand, ::capnp::MallocMessageBuilder& builder);
+    static containers::SimCommand toSimCommand(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
+    static void toMsg(containers::SimCommand simCommand, ::capnp::MallocMessageBuilder& builder, const IDHandleRegistry* handles = nullptr);
+
+    // batches of commands, the decoded commands are appended to the given list
+    static void toSimCommands(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager, std::vector<containers::SimCommand>& simCommands,
+            IDHandleRegistry* handles = nullptr);
+    static void toMsg(const std::vector<containers::SimCommand>& simCommands, ::capnp::MallocMessageBuilder& builder, const IDHandleRegistry* handles = nullptr);
+
+    // for sending commands as part of a message
+    static containers::SimCommand createSimCommand(srg::sim::SimCommandMsg::Reader reader, essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
+    static void toMsg(const containers::SimCommand& simCommand, ::srg::sim::SimCommandMsg::Builder& builder, const IDHandleRegistry* handles = nullptr);
 
     // for sending as standalone message
-    static void toMsg(containers::Perceptions simPerceptions, ::capnp::MallocMessageBuilder& builder);
-    static containers::Perceptions toPerceptions(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager);
+    static void toMsg(const containers::Perceptions& simPerceptions, ::capnp::MallocMessageBuilder& builder);
+    static containers::Perceptions toPerceptions(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
 
     // for sending as part of a message
-    static void toMsg(containers::Perceptions perceptions, ::srg::sim::PerceptionMsg::Builder& builder);
-    static containers::Perceptions createPerceptions(srg::sim::PerceptionMsg::Reader perceptionsReader, essentials::IDManager& idManager);
+    static void toMsg(const containers::Perceptions& perceptions, ::srg::sim::PerceptionMsg::Builder& builder);
+    static containers::Perceptions createPerceptions(
+            srg::sim::PerceptionMsg::Reader perceptionsReader, essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
+
+    // for encoding perceived cells directly from the world, without intermediate containers
+    static void toMsg(essentials::IdentifierConstPtr receiverID, std::chrono::system_clock::duration timestamp,
+            const std::vector<const srg::world::Cell*>& cells, ::srg::sim::PerceptionMsg::Builder& builder, IDHandleRegistry* handles = nullptr);
+    static void toMsg(const srg::world::Object& object, ::srg::sim::PerceptionMsg::Object::Builder& objectBuilder, IDHandleRegistry* handles = nullptr);
+    static std::shared_ptr<srg::world::Object> createObject(
+            srg::sim::PerceptionMsg::Object::Reader& objectReader, essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
+    static srg::world::ObjectType toObjectType(srg::sim::PerceptionMsg::Object::Type type);
+    static srg::world::ObjectState toObjectState(srg::sim::PerceptionMsg::Object::State state);
+    /**
+     * Resolves the handle, if set, otherwise the ID. Returns nullptr for handles unknown to the registry.
+     */
+    static essentials::IdentifierConstPtr createID(capnzero::ID::Reader idReader, uint32_t handle, essentials::IDManager& idManager, IDHandleRegistry* handles);
+
+    // compact perceptions (version 2), the decoding reconstructs the version 1 container
+    static void toMsg(essentials::IdentifierConstPtr receiverID, std::chrono::system_clock::duration timestamp,
+            const std::vector<const srg::world::Cell*>& cells, ::srg::sim::CompactPerceptionMsg::Builder& builder, IDHandleRegistry* handles = nullptr);
+    static containers::Perceptions toCompactPerceptions(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
+    static containers::Perceptions createPerceptions(
+            srg::sim::CompactPerceptionMsg::Reader perceptionsReader, essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
+
+    // optional packing or compression of whole messages
+    static void frame(::srg::sim::FramedMsg::Framing framing, ::capnp::MessageBuilder& payload, std::vector<kj::byte>& buffer,
+            ::srg::sim::FramedMsg::Builder& builder);
+    static kj::Array<::capnp::word> unframe(::srg::sim::FramedMsg::Reader framedReader);
+    static bool isFramingSupported(::srg::sim::FramedMsg::Framing framing);
+
+    // broadcast perceptions, clients reconstruct their perceptions with the WorldDeltaDecoder
+    static void toMsg(uint64_t tick, std::chrono::system_clock::duration timestamp, bool keyframe, const std::vector<const srg::world::Cell*>& cells,
+            ::srg::sim::WorldDeltaMsg::Builder& builder, IDHandleRegistry* handles = nullptr);
+    static void toMsg(essentials::IdentifierConstPtr receiverID, uint64_t tick, std::chrono::system_clock::duration timestamp,
+            const std::vector<const srg::world::Cell*>& cells, ::srg::sim::VisibilityMsg::Builder& builder);
+
+    // announcement of ID handles
+    static void toMsg(const std::vector<uint32_t>& announcedHandles, IDHandleRegistry& handles, ::srg::sim::IDMappingMsg::Builder& builder);
+    static void applyMapping(::srg::sim::IDMappingMsg::Reader mappingReader, essentials::IDManager& idManager, IDHandleRegistry& handles);
+
+    // path queries and their responses
+    static containers::PathQuery toPathQuery(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
+    static void toMsg(const containers::PathQuery& query, ::srg::sim::PathQueryMsg::Builder& builder, const IDHandleRegistry* handles = nullptr);
+    static containers::PathResult toPathResult(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager);
+    static void toMsg(const containers::PathResult& result, ::srg::sim::PathResponseMsg::Builder& builder);
 
 private:
     ContainerUtils() = delete;
-    static void toObjectListMsg(std::vector<std::shared_ptr<srg::world::Object>>& objects, ::capnp::List<::srg::sim::PerceptionMsg::Object>::Builder& objectsListBuilder);
-    static std::shared_ptr<srg::world::Object> createObject(srg::sim::PerceptionMsg::Object::Reader& objectReader, essentials::IDManager& idManager);
+    static void toObjectListMsg(const std::vector<std::shared_ptr<srg::world::Object>>& objects, ::capnp::List<::srg::sim::PerceptionMsg::Object>::Builder& objectsListBuilder);
+    template <class VisibilityBuilder>
+    static void toVisibilityMsg(const std::vector<const srg::world::Cell*>& cells, VisibilityBuilder& builder);
 };
 } // namespace sim
 } // namespace srg
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <essentials/IdentifierConstPtr.h>
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace srg
+{
+namespace sim
+{
+/**
+ * Dense uint32 handles for IDs, so messages don't need to carry the full IDs.
+ * The simulator assigns the handles and announces them with IDMappingMsgs,
+ * clients fill their registry from these announcements.
+ */
+class IDHandleRegistry
+{
+public:
+    static const uint32_t NO_HANDLE = 0;
+
+    IDHandleRegistry();
+
+    /**
+     * Returns the handle of the ID and assigns a new one, if the ID has none yet (simulator side).
+     */
+    uint32_t getHandle(essentials::IdentifierConstPtr id);
+    /**
+     * Returns NO_HANDLE, if the ID has no handle (client side).
+     */
+    uint32_t findHandle(essentials::IdentifierConstPtr id) const;
+    /**
+     * Returns nullptr for unknown handles and remembers them as missing.
+     */
+    essentials::IdentifierConstPtr getID(uint32_t handle);
+    void setMapping(uint32_t handle, essentials::IdentifierConstPtr id);
+    uint32_t getHandleCount() const;
+
+    /**
+     * Moves the handles assigned since the last call into the given list.
+     */
+    void takeUnannounced(std::vector<uint32_t>& handles);
+    /**
+     * Moves the unknown handles asked for since the last call into the given list.
+     */
+    void takeMissing(std::vector<uint32_t>& handles);
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<essentials::IdentifierConstPtr, uint32_t> handles;
+    std::vector<essentials::IdentifierConstPtr> ids; /**< Indexed by handle. */
+    std::unordered_set<uint32_t> missingHandles;
+    uint32_t announcedHandles;
+};
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "srg/sim/containers/PathQuery.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace srg
+{
+class World;
+namespace world
+{
+class Object;
+class RoomGraph;
+} // namespace world
+namespace sim
+{
+/**
+ * Answers path queries with A* over the passability of the grid: walls, cells missing from the grid (e.g., in chunks
+ * that are not resident yet) and cells with a closed door are blocked, agents moving 4-connected like the move commands.
+ * Queries spanning at least hierarchicalDistance cells first search a route over the graph of rooms and doors and
+ * only search the cells between consecutive doors of that route.
+ *
+ * The simulator thread updates the passability and the room graph once per iteration, queries can be answered by any
+ * number of threads at the same time. Each query works on the passability grid and room graph published last and on
+ * search arrays local to its thread, it never locks the world.
+ */
+class PathPlanner
+{
+public:
+    /**
+     * @param maxExpansions Limit of the expanded cells per query, queries can only ask for less.
+     * @param hierarchicalDistance Manhattan distance from which queries are planned over the room graph, 0 disables it.
+     */
+    PathPlanner(World* world, uint32_t maxExpansions, uint32_t hierarchicalDistance);
+
+    /**
+     * Rebuilds the passability and room graph when cells or doors were added and publishes door changes.
+     * Called by the simulator thread.
+     */
+    void update();
+    containers::PathResult findPath(const containers::PathQuery& query) const;
+    uint32_t getMaxExpansions() const;
+
+private:
+    struct PassabilityGrid
+    {
+        uint32_t sizeX;
+        uint32_t sizeY;
+        std::vector<uint8_t> passable; /**< Indexed by x * sizeY + y, like the cells of the map file. */
+        std::shared_ptr<const world::RoomGraph> roomGraph; /**< nullptr if hierarchical planning is disabled. */
+    };
+
+    struct DoorCell
+    {
+        std::shared_ptr<const world::Object> door;
+        uint32_t index;
+        bool open; /**< State at the last update. */
+    };
+
+    void rebuild();
+    void publish(const std::shared_ptr<const world::RoomGraph>& roomGraph);
+    std::shared_ptr<const PassabilityGrid> getGrid() const;
+    /**
+     * A* from one cell to another, the found cells are appended to the path.
+     */
+    containers::PathResult::Status search(const PassabilityGrid& grid, uint32_t fromX, uint32_t fromY, uint32_t toX, uint32_t toY, uint32_t limit,
+            std::vector<std::pair<uint32_t, uint32_t>>& path, uint32_t& expansions) const;
+    containers::PathResult::Status searchHierarchical(const PassabilityGrid& grid, const containers::PathQuery& query, uint32_t limit,
+            std::vector<std::pair<uint32_t, uint32_t>>& path, uint32_t& expansions) const;
+
+    World* world;
+    uint32_t maxExpansions;
+    uint32_t hierarchicalDistance;
+    uint64_t topologyVersion; /**< Of the world at the last rebuild, changes e.g. when chunks are materialized. */
+    std::vector<uint8_t> walls; /**< Passability without doors. */
+    std::vector<DoorCell> doors;
+    std::shared_ptr<const PassabilityGrid> grid;
+    mutable std::mutex gridMutex;
+};
+} // namespace sim
+} // namespace srg
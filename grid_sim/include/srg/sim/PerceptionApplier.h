@@ -0,0 +1,56 @@
+#pragma once
+
+#include <srg/sim/msgs/CompactPerceptionMsg.capnp.h>
+#include <srg/sim/msgs/PerceptionMsg.capnp.h>
+
+#include <essentials/IdentifierConstPtr.h>
+
+#include <capnp/serialize.h>
+
+#include <memory>
+#include <vector>
+
+namespace essentials
+{
+class IDManager;
+}
+
+namespace srg
+{
+class World;
+namespace world
+{
+class Object;
+class ObjectSet;
+} // namespace world
+namespace sim
+{
+class IDHandleRegistry;
+
+/**
+ * Updates the world model of an agent directly from perception messages, in one pass
+ * and without intermediate containers. Existing objects are updated in place, only
+ * objects seen for the first time are allocated. Has the same effect as passing the
+ * result of ContainerUtils::toPerceptions to World::updateCell.
+ */
+class PerceptionApplier
+{
+public:
+    PerceptionApplier(srg::World& world, essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
+
+    void apply(::capnp::FlatArrayMessageReader& msg);
+    void apply(srg::sim::PerceptionMsg::Reader perceptionsReader);
+    void apply(srg::sim::CompactPerceptionMsg::Reader perceptionsReader);
+
+private:
+    void applyObjects(const std::shared_ptr<srg::world::ObjectSet>& objectSet, ::capnp::List<srg::sim::PerceptionMsg::Object>::Reader objectsReader,
+            size_t depth);
+
+    srg::World& world;
+    essentials::IDManager& idManager;
+    IDHandleRegistry* handles;
+    std::vector<std::vector<essentials::IdentifierConstPtr>> seenIDs; /**< Per nesting depth, reused between messages. */
+    std::vector<std::shared_ptr<srg::world::Object>> unseenObjects;
+};
+} // namespace sim
+} // namespace srg
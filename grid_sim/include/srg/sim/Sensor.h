@@ -15,7 +15,6 @@ class SystemConfig;
 
 namespace srg
 {
-class Simulator;
 class World;
 namespace world {
     class Cell;
@@ -30,14 +29,21 @@ class Sensor
 {
 public:
     Sensor(srg::sim::SimulatedAgent* robot);
-    std::vector<containers::CellPerception> createPerceptions(srg::Simulator* simulator);
+    Sensor(srg::sim::SimulatedAgent* robot, uint32_t sightLimit);
+    std::vector<containers::CellPerception> createPerceptions(srg::World* world);
+    /**
+     * Collects the cells in sight of the robot, ordered by their coordinates.
+     * The returned list is reused by the next call.
+     */
+    const std::vector<const world::Cell*>& collectVisibleCells(srg::World* world);
 
 private:
-    std::vector<std::shared_ptr<const world::Cell>>collectCells(world::Coordinate start, world::Coordinate end, srg::World* world);
+    void collectCells(world::Coordinate start, world::Coordinate end, srg::World* world, std::vector<const world::Cell*>& cells);
 
     SimulatedAgent* robot;
     essentials::SystemConfig& sc;
     uint32_t sightLimit;
+    std::vector<const world::Cell*> visibleCells;
 };
 } // namespace sim
-} // namespace srg
\ No newline at end of file
+} // namespace srg
@@ -6,7 +6,7 @@
 
 namespace srg
 {
-class Simulator;
+class World;
 namespace world
 {
 class Agent;
@@ -17,11 +17,13 @@ class SimulatedAgent
 {
 public:
     SimulatedAgent(std::shared_ptr<srg::world::Agent> agent);
+    SimulatedAgent(std::shared_ptr<srg::world::Agent> agent, uint32_t sightLimit);
     world::Coordinate getCoordinate();
     std::shared_ptr<world::Object> getCarriedObject();
     void setCarriedObject(std::shared_ptr<world::Object> object);
     essentials::IdentifierConstPtr getID();
-    containers::Perceptions createSimPerceptions(Simulator* simulator);
+    containers::Perceptions createSimPerceptions(srg::World* world);
+    const std::vector<const world::Cell*>& collectVisibleCells(srg::World* world);
     void executeAction(containers::SimCommand sc, srg::World* world);
 
 private:
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "srg/sim/containers/Perceptions.h"
+
+#include <srg/sim/msgs/WorldDeltaMsg.capnp.h>
+#include <srg/world/Coordinate.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace essentials
+{
+class IDManager;
+}
+
+namespace srg
+{
+namespace sim
+{
+class IDHandleRegistry;
+
+/**
+ * Client side of the broadcast perception mode: keeps the objects of all cells
+ * from the WorldDeltaMsgs and creates the perceptions of an agent from its VisibilityMsgs.
+ */
+class WorldDeltaDecoder
+{
+public:
+    /**
+     * @param handles Resolves ID handles, if the simulator sends them.
+     */
+    explicit WorldDeltaDecoder(essentials::IDManager& idManager, IDHandleRegistry* handles = nullptr);
+
+    /**
+     * Deltas are ignored until the first keyframe, and after a missed tick until the next keyframe.
+     * @return True, if the decoded cells are up to date with the tick of the delta.
+     */
+    bool applyDelta(srg::sim::WorldDeltaMsg::Reader deltaReader);
+    /**
+     * The objects of the perceptions are shared with the decoder, so they must not be modified.
+     * @return False, if the decoded cells are not at the tick of the visibility message.
+     */
+    bool createPerceptions(srg::sim::VisibilityMsg::Reader visibilityReader, containers::Perceptions& perceptions) const;
+
+    bool isSynchronised() const;
+    uint64_t getTick() const;
+
+private:
+    essentials::IDManager& idManager;
+    IDHandleRegistry* handles;
+    std::map<srg::world::Coordinate, std::vector<std::shared_ptr<srg::world::Object>>> cells; /**< Only cells containing objects. */
+    bool synchronised;
+    uint64_t tick;
+};
+} // namespace sim
+} // namespace srg
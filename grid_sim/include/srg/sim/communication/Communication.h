@@ -1,10 +1,17 @@
 #pragma once
 
+#include "srg/sim/communication/MessageArena.h"
+#include "srg/sim/containers/PathQuery.h"
 #include "srg/sim/containers/Perceptions.h"
+#include "srg/sim/containers/SimCommand.h"
+
+#include <srg/sim/msgs/CompactPerceptionMsg.capnp.h>
 
 #include <capnp/serialize-packed.h>
 
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace essentials
@@ -13,37 +20,96 @@ class IDManager;
 class SystemConfig;
 } // namespace essentials
 
-namespace capnzero
-{
-class Subscriber;
-class Publisher;
-} // namespace capnzero
-
 namespace srg
 {
 class Simulator;
+class World;
+namespace world
+{
+class Cell;
+} // namespace world
 namespace sim
 {
+class IDHandleRegistry;
+class SimulatedAgent;
 namespace communication
 {
+class Transport;
+
 class Communication
 {
 public:
-    Communication(essentials::IDManager* idManager, Simulator* simulator);
+    /**
+     * @param transport Transport to use instead of the configured one, it is not deleted by the communication.
+     */
+    Communication(essentials::IDManager* idManager, Simulator* simulator, Transport* transport = nullptr);
     ~Communication();
 
-    void sendSimPerceptions(srg::sim::containers::Perceptions sp);
+    Transport* getTransport();
+
+    void sendSimPerceptions(const srg::sim::containers::Perceptions& sp);
+    /**
+     * Encodes the perceptions of the given agent directly from the world into the message.
+     */
+    void sendSimPerceptions(srg::sim::SimulatedAgent* agent, srg::World* world);
+    /**
+     * Broadcast perception mode only: sends the cells changed since the last tick,
+     * the following sendSimPerceptions calls only send the visibility of the agents.
+     */
+    void sendWorldDelta(srg::World* world);
+    /**
+     * Sends the responses to the path queries answered since the last call.
+     */
+    void sendPathResponses();
+    /**
+     * Frees the message arenas of an agent that is no longer simulated.
+     */
+    void removeAgent(essentials::IdentifierConstPtr agentID);
 
 private:
     void onSimCommand(::capnp::FlatArrayMessageReader& msg);
+    void onSimCommandBatch(::capnp::FlatArrayMessageReader& msg);
+    void onIDMappingRequest(::capnp::FlatArrayMessageReader& msg);
+    void onPathQuery(::capnp::FlatArrayMessageReader& msg);
+    void readPerceptionFormat();
+    void readPerceptionMode();
+    void readIDHandles();
+    void announceIDHandles();
+    Transport* createTransport();
+    void send(::capnp::MallocMessageBuilder& msgBuilder, essentials::IdentifierConstPtr receiverID);
+    void sendPerception(const std::string& topic, ::capnp::MallocMessageBuilder& msgBuilder);
 
     essentials::SystemConfig& sc;
-    void* ctx;
+    Transport* transport;
+    bool ownsTransport;
     std::string simCommandTopic;
+    std::string simCommandBatchTopic;
     std::string simPerceptionsTopic;
-    std::string address;
-    capnzero::Subscriber* simCommandSub;
-    capnzero::Publisher* simPerceptionsPub;
+    std::string worldDeltaTopic;
+    std::string visibilityTopic;
+    std::vector<containers::SimCommand> simCommandBatch;
+    std::unordered_map<essentials::IdentifierConstPtr, MessageArena> perceptionArenas;
+    bool compactPerceptions;
+    srg::sim::FramedMsg::Framing perceptionFraming;
+    std::unordered_map<essentials::IdentifierConstPtr, MessageArena> framingArenas;
+    std::vector<kj::byte> framingBuffer;
+    bool broadcastPerceptions;
+    uint64_t deltaTick;
+    uint64_t keyframeInterval;
+    std::vector<const world::Cell*> deltaCells;
+    MessageArena deltaArena;
+    IDHandleRegistry* idHandles;
+    std::string idMappingTopic;
+    std::string idMappingRequestTopic;
+    std::vector<uint32_t> announcedHandles;
+    std::vector<uint32_t> requestedHandles;
+    bool allHandlesRequested;
+    std::mutex requestedHandlesMutex;
+    std::string pathQueryTopic;
+    std::string pathResponseTopic;
+    std::vector<containers::PathResult> pathResults;
+    std::vector<containers::PathResult> sentPathResults;
+    std::mutex pathResultsMutex;
 
     essentials::IDManager* idManager;
     Simulator* simulator;
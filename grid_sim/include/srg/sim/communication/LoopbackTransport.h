@@ -0,0 +1,50 @@
+#pragma once
+
+#include "srg/sim/communication/Transport.h"
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+/**
+ * In-process transport for running agents, benchmarks and tests together with
+ * an embedded simulator. Messages are serialized into memory and either handed
+ * to the subscribers right away (in the thread of the sender), or queued until
+ * the receiving thread calls poll().
+ */
+class LoopbackTransport : public Transport
+{
+public:
+    explicit LoopbackTransport(bool queued = false);
+
+    void subscribe(const std::string& topic, Callback callback) override;
+    void send(const std::string& topic, ::capnp::MallocMessageBuilder& msgBuilder) override;
+
+    /**
+     * Delivers the queued messages to the subscribers.
+     * @return Number of delivered messages.
+     */
+    size_t poll();
+
+private:
+    void deliver(const std::string& topic, kj::ArrayPtr<const ::capnp::word> words);
+
+    bool queued;
+    std::multimap<std::string, Callback> subscriptions;
+    std::recursive_mutex subscriptionMutex; /**< Recursive, so subscribers can send from their callbacks. */
+    bool delivering;
+    std::vector<::capnp::word> buffer;
+    std::deque<std::pair<std::string, kj::Array<::capnp::word>>> queue;
+    std::mutex queueMutex;
+};
+} // namespace communication
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <capnp/message.h>
+#include <kj/array.h>
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+/**
+ * Reusable first segment for capnp message builders.
+ *
+ * The builder zeroes the used part of the segment on destruction. The segment
+ * grows to the size of the largest message built so far, so that in steady
+ * state every message fits into the first segment and building it does not
+ * touch the heap.
+ * Not thread-safe, use one arena per agent or per thread.
+ */
+class MessageArena
+{
+public:
+    explicit MessageArena(size_t initialSizeInWords = 1024);
+
+    /**
+     * @return Zeroed memory to be passed as first segment to a ::capnp::MallocMessageBuilder.
+     */
+    kj::ArrayPtr<::capnp::word> getFirstSegment();
+    /**
+     * Remembers the size of the message for sizing the next first segment.
+     * Has to be called before the builder is destroyed.
+     * @param builder The builder that was constructed with getFirstSegment().
+     */
+    void recycle(::capnp::MallocMessageBuilder& builder);
+    size_t getSizeInWords() const;
+
+private:
+    void allocate(size_t sizeInWords);
+
+    kj::Array<::capnp::word> firstSegment;
+    size_t requiredSizeInWords;
+};
+} // namespace communication
+} // namespace sim
+} // namespace srg
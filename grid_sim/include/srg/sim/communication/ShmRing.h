@@ -0,0 +1,91 @@
+#pragma once
+
+#include <capnp/message.h>
+#include <capnp/serialize.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+/**
+ * Broadcast ring buffer of capnp messages in a POSIX shared memory segment
+ * (/dev/shm/srgsim_<topic>).
+ *
+ * Any number of processes can write, writers reserve slots with an atomic
+ * counter. Any number of processes can read, every reader keeps its own
+ * cursor and copies each message out of its slot before handing it out. A
+ * reader that is lapped by the writers skips the overwritten messages and
+ * counts them as lost, the same holds for a slot that got overwritten while
+ * it was copied.
+ *
+ * The first process opening a topic creates and initialises the segment, all
+ * others attach to it and never reset it. The creator unlinks the segment when
+ * it closes the ring, segments left behind by crashed processes are reused as
+ * they are or can be removed from /dev/shm.
+ */
+class ShmRing
+{
+public:
+    static const uint32_t MAGIC = 0x53524752; // "SRGR"
+    static const uint32_t VERSION = 1;
+    static const int ATTACH_ATTEMPTS = 100; /**< Milliseconds to wait for the creator to initialise the segment. */
+
+    /**
+     * @param topic Name of the ring, usually the topic of the messages.
+     * @param create Creates the segment if it does not exist yet, otherwise only an existing segment is attached to.
+     */
+    ShmRing(const std::string& topic, bool create, uint32_t slotCount = 64, uint32_t slotSize = 65536);
+    ~ShmRing();
+
+    bool isValid() const;
+    /**
+     * Serializes the message directly into the next slot.
+     * @return False, if the message does not fit into a slot.
+     */
+    bool write(::capnp::MessageBuilder& msgBuilder);
+    /**
+     * Calls the callback with a reader on the next unread message, if any.
+     * @return False, if there was no message to read.
+     */
+    bool read(const std::function<void(::capnp::FlatArrayMessageReader&)>& callback);
+    uint64_t getLostMessages() const;
+
+    static std::string toSegmentName(const std::string& topic);
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t slotSize;
+        std::atomic<uint64_t> head; /**< Sequence number of the next slot to be written. */
+    };
+
+    struct SlotHeader
+    {
+        std::atomic<uint64_t> sequence; /**< Sequence number + 1 of the published message, 0 while written. */
+        uint64_t size;                  /**< Size of the message in bytes. */
+    };
+
+    SlotHeader* getSlot(uint64_t sequence);
+
+    std::string name;
+    int fd;
+    size_t segmentSize;
+    Header* header;
+    uint64_t cursor;
+    kj::Array<::capnp::word> buffer; /**< Copy of the slot being read, the callback never sees the shared memory. */
+    uint64_t lostMessages;
+    bool created; /**< Whether this process created the segment and has to unlink it. */
+};
+} // namespace communication
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "srg/sim/communication/Transport.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+class ShmRing;
+
+/**
+ * Transport via ring buffers in shared memory for agents on the same host.
+ * Every topic is a ShmRing, messages are serialized once into the ring and
+ * read in place by all subscribers. The simulator creates the rings, so it
+ * has to be started before the agents.
+ */
+class ShmTransport : public Transport
+{
+public:
+    ShmTransport(uint32_t slotCount, uint32_t slotSize, std::chrono::microseconds pollInterval);
+    ~ShmTransport() override;
+
+    void subscribe(const std::string& topic, Callback callback) override;
+    void send(const std::string& topic, ::capnp::MallocMessageBuilder& msgBuilder) override;
+
+private:
+    ShmRing* getRing(const std::string& topic);
+    void receive();
+
+    uint32_t slotCount;
+    uint32_t slotSize;
+    std::chrono::microseconds pollInterval;
+    std::map<std::string, ShmRing*> rings;
+    std::mutex ringMutex;
+    std::vector<std::pair<ShmRing*, Callback>> subscriptions;
+    std::mutex subscriptionMutex;
+    std::atomic<bool> running;
+    std::thread* receiver;
+};
+} // namespace communication
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <capnp/message.h>
+#include <capnp/serialize.h>
+
+#include <functional>
+#include <string>
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+/**
+ * Publish/subscribe of capnp messages on named topics.
+ * Callbacks are called from a receiving thread of the transport.
+ */
+class Transport
+{
+public:
+    typedef std::function<void(::capnp::FlatArrayMessageReader&)> Callback;
+
+    virtual ~Transport() {}
+
+    virtual void subscribe(const std::string& topic, Callback callback) = 0;
+    virtual void send(const std::string& topic, ::capnp::MallocMessageBuilder& msgBuilder) = 0;
+};
+} // namespace communication
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "srg/sim/communication/Transport.h"
+
+#include <map>
+#include <vector>
+
+namespace capnzero
+{
+class Subscriber;
+class Publisher;
+} // namespace capnzero
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+/**
+ * Transport via capnzero over UDP multicast.
+ */
+class UDPTransport : public Transport
+{
+public:
+    explicit UDPTransport(const std::string& address);
+    ~UDPTransport() override;
+
+    void subscribe(const std::string& topic, Callback callback) override;
+    void send(const std::string& topic, ::capnp::MallocMessageBuilder& msgBuilder) override;
+
+private:
+    /**
+     * Adapts the member function callbacks of capnzero to std::function.
+     */
+    struct Subscription
+    {
+        explicit Subscription(Callback callback);
+        void onMessage(::capnp::FlatArrayMessageReader& msg);
+
+        Callback callback;
+    };
+
+    void* ctx;
+    std::string address;
+    std::vector<capnzero::Subscriber*> subscribers;
+    std::vector<Subscription*> subscriptions;
+    std::map<std::string, capnzero::Publisher*> publishers;
+};
+} // namespace communication
+} // namespace sim
+} // namespace srg
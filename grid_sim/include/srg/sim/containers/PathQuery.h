@@ -0,0 +1,48 @@
+#pragma once
+
+#include <essentials/IdentifierConstPtr.h>
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace srg
+{
+namespace sim
+{
+namespace containers
+{
+struct PathQuery
+{
+    uint64_t requestID;
+    essentials::IdentifierConstPtr senderID;
+    uint32_t fromX;
+    uint32_t fromY;
+    uint32_t toX;
+    uint32_t toY;
+    uint32_t maxExpansions; /**< 0 for the limit of the simulator. */
+    std::chrono::system_clock::duration timestamp;
+};
+
+struct PathResult
+{
+    enum class Status
+    {
+        Found,
+        NoPath,
+        ExpansionLimit, /**< The search was aborted before reaching the goal. */
+        Invalid         /**< Start or goal are outside of the world or not passable. */
+    };
+
+    uint64_t requestID;
+    essentials::IdentifierConstPtr receiverID;
+    Status status;
+    std::vector<std::pair<uint32_t, uint32_t>> path; /**< Cells from start to goal, both included. */
+    uint32_t expansions;
+    std::chrono::nanoseconds latency;
+    std::chrono::system_clock::duration timestamp;
+};
+} // namespace containers
+} // namespace sim
+} // namespace srg
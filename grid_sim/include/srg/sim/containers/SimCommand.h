@@ -16,6 +16,7 @@ namespace containers
 struct SimCommand
 {
     std::chrono::system_clock::duration timestamp;
+    std::chrono::system_clock::duration receiveTime = std::chrono::system_clock::duration::zero(); /**< Set by the simulator, not transmitted. */
     essentials::IdentifierConstPtr senderID;
     Action action;
     essentials::IdentifierConstPtr objectID;
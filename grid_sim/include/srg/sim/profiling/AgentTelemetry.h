@@ -0,0 +1,65 @@
+#pragma once
+
+#include "srg/sim/profiling/Histogram.h"
+#include "srg/sim/containers/SimCommand.h"
+
+#include <essentials/IdentifierConstPtr.h>
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <mutex>
+#include <unordered_map>
+
+namespace srg
+{
+namespace sim
+{
+namespace profiling
+{
+/**
+ * Latencies of the commands and perceptions of one agent.
+ */
+struct AgentLatencies
+{
+    AgentLatencies();
+
+    Histogram sendToReceive;     /**< Timestamp of the command until it was received, includes clock offsets of the agent. */
+    Histogram receiveToApply;    /**< Time spent in the command queue of the simulator. */
+    Histogram applyToPerception; /**< Applying a command until the agent got perceptions of the result. */
+    std::atomic<uint64_t> received;
+    std::atomic<uint64_t> dropped; /**< Commands dropped, because the agent had a command queued for this iteration already. */
+    std::atomic<uint64_t> clockSkewed; /**< Commands received before their timestamp. */
+    std::chrono::system_clock::duration lastApply; /**< Zero, if no perception is pending. Simulator thread only. */
+};
+
+/**
+ * Per agent command and perception latencies. Commands are received and dropped
+ * in the threads of the transport, applied and answered by the simulator thread.
+ */
+class AgentTelemetry
+{
+public:
+    ~AgentTelemetry();
+
+    void recordReceived(const containers::SimCommand& simCommand);
+    void countDropped(essentials::IdentifierConstPtr agentID);
+    void recordApplied(const containers::SimCommand& simCommand);
+    void recordPerceptionSent(essentials::IdentifierConstPtr agentID);
+    /**
+     * Returns nullptr for agents without any commands.
+     */
+    const AgentLatencies* getLatencies(essentials::IdentifierConstPtr agentID) const;
+
+    void writeJSON(std::ostream& os) const;
+    void writeCSV(std::ostream& os) const;
+
+private:
+    AgentLatencies& getOrCreateLatencies(essentials::IdentifierConstPtr agentID);
+
+    mutable std::mutex agentsMutex;
+    std::unordered_map<essentials::IdentifierConstPtr, AgentLatencies*> agents;
+};
+} // namespace profiling
+} // namespace sim
+} // namespace srg
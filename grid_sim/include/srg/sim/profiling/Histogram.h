@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace srg
+{
+namespace sim
+{
+namespace profiling
+{
+/**
+ * Lock-free log-linear histogram for durations in nanoseconds.
+ * Every power of two is split into 8 linear sub-buckets, so the relative
+ * error of reported quantiles is below 12.5%. Recording is wait-free apart
+ * from the max update and can be done from any thread.
+ */
+class Histogram
+{
+public:
+    static const uint32_t SUB_BUCKETS = 8;
+    static const uint32_t BUCKET_COUNT = 496;
+
+    Histogram();
+
+    void record(uint64_t nanoseconds);
+    void record(std::chrono::nanoseconds duration);
+    void reset();
+
+    uint64_t getCount() const;
+    uint64_t getSum() const;
+    uint64_t getMax() const;
+    double getMean() const;
+    /**
+     * Upper bound of the bucket that contains the given quantile.
+     * @param quantile Value in [0, 1]
+     * @return Nanoseconds
+     */
+    uint64_t getQuantile(double quantile) const;
+    uint64_t getBucketCount(uint32_t bucket) const;
+
+    static uint32_t toBucket(uint64_t nanoseconds);
+    static uint64_t bucketUpperBound(uint32_t bucket);
+
+    void writeJSON(std::ostream& os) const;
+    void writeCSV(std::ostream& os, const std::string& name) const;
+
+private:
+    std::atomic<uint64_t> buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+};
+
+/**
+ * Records the time between its construction and destruction into a histogram.
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Histogram& histogram);
+    ~ScopedTimer();
+
+private:
+    Histogram& histogram;
+    std::chrono::steady_clock::time_point start;
+};
+} // namespace profiling
+} // namespace sim
+} // namespace srg
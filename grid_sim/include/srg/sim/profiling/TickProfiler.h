@@ -0,0 +1,94 @@
+#pragma once
+
+#include "srg/sim/profiling/AgentTelemetry.h"
+#include "srg/sim/profiling/Histogram.h"
+#include "srg/sim/containers/Action.h"
+
+#include <essentials/IdentifierConstPtr.h>
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+
+namespace srg
+{
+namespace sim
+{
+namespace profiling
+{
+enum class Phase
+{
+    Tick,
+    GUI,
+    Commands,
+    Displacement,
+    Perception,
+    Serialization,
+    Send,
+    PathQuery, // recorded by the threads answering path queries, not part of the tick
+    Last // has to be last for iterating with ints over this enum
+};
+
+std::ostream& operator<<(std::ostream& os, const Phase& phase);
+
+/**
+ * Collects timings of the phases of each simulator iteration.
+ * Histograms are recorded lock-free, the per agent histograms are
+ * created and dumped by the simulator thread only.
+ */
+class TickProfiler
+{
+public:
+    TickProfiler();
+    ~TickProfiler();
+
+    Histogram& getHistogram(Phase phase);
+    Histogram& getHistogram(containers::Action action);
+    Histogram& getPerceptionHistogram(essentials::IdentifierConstPtr agentID);
+    AgentTelemetry& getAgentTelemetry();
+    void countOverrun();
+    uint64_t getOverruns() const;
+    void countCommand();
+    uint64_t getCommands() const;
+    /**
+     * Counts perceptions, world deltas and visibilities sent to the agents.
+     */
+    void countPerception(size_t bytes);
+    uint64_t getPerceptionMessages() const;
+    uint64_t getPerceptionBytes() const;
+    uint64_t getTicks() const;
+
+    /**
+     * Writes the histograms to the configured file, if the dump interval has passed or a dump was requested.
+     */
+    void dumpPeriodically();
+    /**
+     * Requests a dump with the next dumpPeriodically call, can be called from signal handlers (e.g., SIGUSR1).
+     */
+    static void requestDump(int sig = 0);
+    /**
+     * Writes the histograms to the configured file, regardless of the dump interval.
+     */
+    void dump();
+    void writeJSON(std::ostream& os) const;
+    void writeCSV(std::ostream& os) const;
+
+private:
+    Histogram phases[static_cast<int>(Phase::Last)];
+    Histogram actions[containers::Action::CLOSE + 1];
+    std::unordered_map<essentials::IdentifierConstPtr, Histogram*> agentPerceptions;
+    std::atomic<uint64_t> overruns;
+    std::atomic<uint64_t> commands;
+    std::atomic<uint64_t> perceptionMessages;
+    std::atomic<uint64_t> perceptionBytes;
+    AgentTelemetry agentTelemetry;
+    static std::atomic<bool> dumpRequested;
+
+    std::string dumpFile;
+    std::chrono::steady_clock::duration dumpInterval;
+    std::chrono::steady_clock::time_point lastDump;
+};
+} // namespace profiling
+} // namespace sim
+} // namespace srg
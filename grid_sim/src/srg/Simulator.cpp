@@ -1,5 +1,7 @@
 #include "srg/Simulator.h"
 
+#include "srg/sim/CheckpointWriter.h"
+#include "srg/sim/PathPlanner.h"
 #include "srg/sim/Sensor.h"
 #include "srg/sim/SimulatedAgent.h"
 #include "srg/sim/commands/CommandHandler.h"
@@ -7,17 +9,25 @@
 #include "srg/sim/commands/MoveCommandHandler.h"
 #include "srg/sim/commands/SpawnCommandHandler.h"
 #include "srg/sim/communication/Communication.h"
+#include "srg/sim/profiling/TickProfiler.h"
 
 #include <srg/GUI.h>
 #include <srg/World.h>
+#include <srg/viz/Recorder.h>
+#include <srg/viz/SnapshotBuilder.h>
+#include <srg/viz/WorldSnapshot.h>
 #include <srg/world/Agent.h>
+#include <srg/world/Checkpoint.h>
+#include <srg/world/Scenario.h>
 
 #include <essentials/IDManager.h>
 #include <essentials/SystemConfig.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
-#include <signal.h>
+#include <random>
 #include <string>
 #include <thread>
 
@@ -27,21 +37,75 @@ namespace srg
 {
 bool Simulator::running = false;
 
-Simulator::Simulator(bool headless)
+Simulator::Simulator(bool headless, sim::communication::Transport* transport)
         : headless(headless)
         , idManager(new essentials::IDManager())
         , sc(essentials::SystemConfig::getInstance())
+        , profiler(new sim::profiling::TickProfiler())
+        , gui(nullptr)
+        , snapshotBuilder(new viz::SnapshotBuilder())
+        , snapshot(new viz::WorldSnapshot())
+        , recorder(nullptr)
+        , recordingInterval(1)
+        , lastTickDuration(0)
+        , chunkActivationRange(0)
+        , tick(0)
+        , checkpointWriter(nullptr)
+        , checkpointInterval(0)
+        , pathPlanner(nullptr)
+        , mainThread(nullptr)
 {
-    this->world = new World(*this->idManager);
-    this->placeObjectsFromConf();
+    // relative map files are found in the config folder, e.g., generated buildings next to their Objects.conf
+    std::string mapFile = sc["SRGSim"]->tryGet<std::string>("textures/Department.tmx", "SRGSim.World.map", NULL);
+    if (mapFile.empty() || mapFile[0] != '/') {
+        mapFile = sc.getConfigPath() + mapFile;
+    }
+    this->world = new World(mapFile, *this->idManager, sc["SRGSim"]->tryGet<uint32_t>(0, "SRGSim.World.chunkSize", NULL));
+    // agents move one cell per iteration, so chunks are materialized before they come into sight
+    this->chunkActivationRange =
+            sc["SRGSim"]->tryGet<uint32_t>(sc["ObjectDetection"]->tryGet<uint32_t>(10, "sightLimit", NULL) + 1, "SRGSim.World.activationRange", NULL);
+    this->world->seedRandom(sc["SRGSim"]->tryGet<uint32_t>(std::mt19937::default_seed, "SRGSim.seed", NULL));
+    std::string scenarioFile = sc["SRGSim"]->tryGet<std::string>("", "SRGSim.Scenario.file", NULL);
+    if (scenarioFile.empty()) {
+        this->placeObjectsFromConf();
+    } else {
+        this->placeObjectsFromScenario(scenarioFile[0] == '/' ? scenarioFile : sc.getConfigPath() + scenarioFile);
+    }
+    this->createRecorderFromConf();
+    this->createCheckpointWriterFromConf();
+    // the passability is built with the first iteration, queries before are answered as invalid
+    this->pathPlanner = new sim::PathPlanner(this->world, sc["SRGSim"]->tryGet<uint32_t>(100000, "SRGSim.PathPlanning.maxExpansions", NULL),
+            sc["SRGSim"]->tryGet<uint32_t>(64, "SRGSim.PathPlanning.hierarchicalDistance", NULL));
     this->communicationHandlers.push_back(new sim::commands::MoveCommandHandler(this));
     this->communicationHandlers.push_back(new sim::commands::ManipulationHandler(this));
     this->communicationHandlers.push_back(new sim::commands::SpawnCommandHandler(this));
-    this->communication = new sim::communication::Communication(this->idManager, this);
+    this->communication = new sim::communication::Communication(this->idManager, this, transport);
+}
+
+/**
+ * Loads the objects of a scenario file in one pass and places them with one lock of the world.
+ */
+void Simulator::placeObjectsFromScenario(const std::string& scenarioFile)
+{
+    auto start = std::chrono::steady_clock::now();
+    world::Scenario scenario;
+    if (!scenario.load(scenarioFile)) {
+        return;
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    uint32_t deferred;
+    uint32_t placed = this->world->placeObjects(scenario.getObjects(), *this->idManager, deferred);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "[Simulator] Placed " << placed << " of " << scenario.getObjects().size() << " objects from '" << scenarioFile << "' (" << deferred
+              << " deferred until their chunk is loaded) in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms (parsing "
+              << std::chrono::duration<double, std::milli>(parsed - start).count() << " ms, placing "
+              << std::chrono::duration<double, std::milli>(end - parsed).count() << " ms, " << scenario.getErrorCount() << " invalid lines)" << std::endl;
 }
 
 void Simulator::placeObjectsFromConf()
 {
+    auto start = std::chrono::steady_clock::now();
     std::shared_ptr<std::vector<std::string>> objectSections = sc["Objects"]->getSections("Objects", NULL);
     for (std::string objectSection : *objectSections) {
         int32_t intObjectID = std::stoi(objectSection);
@@ -82,12 +146,77 @@ void Simulator::placeObjectsFromConf()
             std::cout << "[Simulator] Placement of " << type << " to " << coord << " not allowed!" << std::endl;
         }
     }
+    std::cout << "[Simulator] Loaded " << objectSections->size() << " objects from Objects.conf in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+}
+
+void Simulator::createRecorderFromConf()
+{
+    if (!sc["SRGSim"]->tryGet<bool>(false, "SRGSim.Recording.enabled", NULL)) {
+        return;
+    }
+    std::string format = sc["SRGSim"]->tryGet<std::string>("png", "SRGSim.Recording.format", NULL);
+    if (format != "png" && format != "raw") {
+        std::cerr << "[Simulator] Unknown recording format '" << format << "', using png!" << std::endl;
+    }
+    this->recordingInterval = std::max(1u, sc["SRGSim"]->tryGet<uint32_t>(33, "SRGSim.Recording.interval", NULL));
+    this->recorder = new viz::Recorder(sc["SRGSim"]->tryGet<std::string>("recording", "SRGSim.Recording.directory", NULL),
+            format == "raw" ? viz::Recorder::Format::Raw : viz::Recorder::Format::PNG, sc["SRGSim"]->tryGet<uint32_t>(1024, "SRGSim.Recording.width", NULL),
+            sc["SRGSim"]->tryGet<uint32_t>(1024, "SRGSim.Recording.height", NULL), sc["SRGSim"]->tryGet<uint32_t>(16, "SRGSim.Recording.queueSize", NULL),
+            sc["SRGSim"]->tryGet<float>(6.0, "SRGSim.Recording.lodPixelsPerCell", NULL));
+}
+
+void Simulator::createCheckpointWriterFromConf()
+{
+    this->checkpointInterval = sc["SRGSim"]->tryGet<uint32_t>(0, "SRGSim.Checkpoint.interval", NULL);
+    if (this->checkpointInterval == 0) {
+        return;
+    }
+    this->checkpointWriter = new sim::CheckpointWriter(sc["SRGSim"]->tryGet<std::string>("checkpoints", "SRGSim.Checkpoint.directory", NULL));
+}
+
+/**
+ * Only copying the state blocks the loop, the checkpoint is written by the checkpoint writer.
+ */
+void Simulator::writeCheckpoint()
+{
+    world::Checkpoint* checkpoint = new world::Checkpoint();
+    this->world->captureCheckpoint(*checkpoint);
+    checkpoint->tick = this->tick;
+    this->checkpointWriter->write(checkpoint);
+}
+
+bool Simulator::restore(const std::string& checkpointFile)
+{
+    auto start = std::chrono::steady_clock::now();
+    world::Checkpoint checkpoint;
+    if (!checkpoint.read(checkpointFile)) {
+        return false;
+    }
+    std::vector<std::shared_ptr<world::Agent>> agents;
+    if (!this->world->restoreCheckpoint(checkpoint, *this->idManager, agents)) {
+        return false;
+    }
+    for (auto& agent : agents) {
+        this->addSimulatedAgent(agent);
+    }
+    this->tick = checkpoint.tick;
+    std::cout << "[Simulator] Restored iteration " << this->tick << " from '" << checkpointFile << "' in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+    return true;
+}
+
+uint64_t Simulator::getTick() const
+{
+    return this->tick;
 }
 
 Simulator::~Simulator()
 {
-    this->mainThread->join();
-    delete mainThread;
+    if (this->mainThread) {
+        this->mainThread->join();
+        delete this->mainThread;
+    }
     delete this->communication;
     for (auto& handler : this->communicationHandlers) {
         delete handler;
@@ -95,6 +224,12 @@ Simulator::~Simulator()
     delete this->idManager;
     delete this->world;
     delete this->gui;
+    delete this->recorder;
+    delete this->checkpointWriter;
+    delete this->pathPlanner;
+    delete this->snapshot;
+    delete this->snapshotBuilder;
+    delete this->profiler;
 }
 
 srg::World* Simulator::getWorld()
@@ -102,6 +237,28 @@ srg::World* Simulator::getWorld()
     return this->world;
 }
 
+sim::profiling::TickProfiler* Simulator::getProfiler()
+{
+    return this->profiler;
+}
+
+sim::containers::PathResult Simulator::findPath(const sim::containers::PathQuery& query) const
+{
+    sim::containers::PathResult result = this->pathPlanner->findPath(query);
+    this->profiler->getHistogram(sim::profiling::Phase::PathQuery).record(result.latency);
+    return result;
+}
+
+sim::PathPlanner* Simulator::getPathPlanner()
+{
+    return this->pathPlanner;
+}
+
+sim::communication::Transport* Simulator::getTransport()
+{
+    return this->communication->getTransport();
+}
+
 void Simulator::addSimulatedAgent(std::shared_ptr<world::Agent> agent)
 {
     if (!agent)
@@ -115,6 +272,19 @@ void Simulator::addSimulatedAgent(std::shared_ptr<world::Agent> agent)
     this->simulatedAgents.push_back(new sim::SimulatedAgent(agent));
 }
 
+void Simulator::removeSimulatedAgent(essentials::IdentifierConstPtr id)
+{
+    auto agentIter = std::find_if(simulatedAgents.begin(), simulatedAgents.end(), [id](sim::SimulatedAgent* a) { return a->getID() == id; });
+    if (agentIter == simulatedAgents.end()) {
+        return;
+    }
+
+    std::cout << "[Simulator] Removing agent " << *id << std::endl;
+    delete *agentIter;
+    this->simulatedAgents.erase(agentIter);
+    this->communication->removeAgent(id);
+}
+
 sim::SimulatedAgent* Simulator::getAgent(essentials::IdentifierConstPtr id)
 {
     for (sim::SimulatedAgent* robot : simulatedAgents) {
@@ -125,9 +295,26 @@ sim::SimulatedAgent* Simulator::getAgent(essentials::IdentifierConstPtr id)
     return nullptr;
 }
 
+// markers are only taken by the snapshot builder, if something renders them, step() discards them otherwise
 void Simulator::addMarker(viz::Marker marker)
 {
-    this->gui->addMarker(marker);
+    if (!this->headless || this->recorder) {
+        this->snapshotBuilder->addMarker(marker);
+    }
+}
+
+void Simulator::addMarkers(std::vector<viz::Marker> markers)
+{
+    if (!this->headless || this->recorder) {
+        this->snapshotBuilder->addMarkers(std::move(markers));
+    }
+}
+
+void Simulator::removeMarker(uint64_t id)
+{
+    if (!this->headless || this->recorder) {
+        this->snapshotBuilder->removeMarker(id);
+    }
 }
 
 void Simulator::start()
@@ -149,42 +336,7 @@ void Simulator::run()
         std::cout << "[Simulator] Updating GUI..." << std::endl;
 #endif
         auto start = std::chrono::system_clock::now();
-
-        // Update GUI
-        if (!this->headless) {
-            this->gui->draw(this->world);
-        }
-
-#ifdef SIM_DEBUG
-        std::cout << "[Simulator] Handle commands..." << std::endl;
-#endif
-        // Handle Commands
-        {
-            std::lock_guard<std::recursive_mutex> guard(commandMutex);
-            while (this->commandQueue.size() > 0) {
-                srg::sim::containers::SimCommand sc = this->commandQueue.front();
-                this->commandQueue.pop_front();
-                for (sim::commands::CommandHandler* handler : this->communicationHandlers) {
-                    if (handler->handle(sc)) {
-                        break;
-                    }
-                }
-            }
-        }
-
-        // Displace some object (almost) randomly
-        if (rand() % 200 < 2) { // 1% chance of displacing an object
-            this->world->displaceObject();
-        }
-
-#ifdef SIM_DEBUG
-        std::cout << "[Simulator] Create and send perceptions..." << std::endl;
-#endif
-        // Produce and send perceptions for each robot
-        assert(this->simulatedAgents.size() < 5);
-        for (auto& simulatedAgent : this->simulatedAgents) {
-            this->communication->sendSimPerceptions(simulatedAgent->createSimPerceptions(this));
-        }
+        this->step();
 
         // Sleep in order to keep the cpu effort low
         auto timePassed = std::chrono::system_clock::now() - start;
@@ -194,26 +346,143 @@ void Simulator::run()
         std::cout << "[Simulator] Iteration took " << millisecondsPassed.count() << " ms. Sleep " << 20 - millisecondsPassed.count()
                   << "ms to keep frequency..." << std::endl;
 #endif
+        this->profiler->dumpPeriodically();
         if (millisecondsPassed.count() < 30) { // Simulator frequency is 33 times per seconds!
             std::this_thread::sleep_for(std::chrono::milliseconds(30 - millisecondsPassed.count()));
         } else {
+            this->profiler->countOverrun();
             std::cerr << "[Simulator] ...iteration overshoot!\n------------------------------" << std::endl;
         }
 #ifdef SIM_DEBUG
         std::cout << "[Simulator] ...iteration end!\n------------------------------" << std::endl;
 #endif
     }
+
+    // final dump and checkpoint, e.g., after [Ctrl] + [c]
+    this->profiler->dump();
+    if (this->checkpointWriter) {
+        this->writeCheckpoint();
+    }
+}
+
+void Simulator::step()
+{
+    sim::profiling::ScopedTimer tickTimer(this->profiler->getHistogram(sim::profiling::Phase::Tick));
+    auto tickStart = std::chrono::steady_clock::now();
+
+    // Publish the world to the GUI and the recorder, they render in their own threads
+    if (this->gui || (this->recorder && this->tick % this->recordingInterval == 0)) {
+        sim::profiling::ScopedTimer guiTimer(this->profiler->getHistogram(sim::profiling::Phase::GUI));
+        this->publishSnapshot();
+    } else if (!this->recorder) {
+        // the GUI is only created by run(), nothing takes the markers if step() is driven without it
+        this->snapshotBuilder->discardMarkers();
+    }
+
+#ifdef SIM_DEBUG
+    std::cout << "[Simulator] Handle commands..." << std::endl;
+#endif
+    // Handle Commands
+    {
+        sim::profiling::ScopedTimer commandsTimer(this->profiler->getHistogram(sim::profiling::Phase::Commands));
+        std::lock_guard<std::recursive_mutex> guard(commandMutex);
+        while (this->commandQueue.size() > 0) {
+            srg::sim::containers::SimCommand sc = this->commandQueue.front();
+            this->commandQueue.pop_front();
+            sim::profiling::ScopedTimer actionTimer(this->profiler->getHistogram(sc.action));
+            this->profiler->getAgentTelemetry().recordApplied(sc);
+            this->profiler->countCommand();
+            for (sim::commands::CommandHandler* handler : this->communicationHandlers) {
+                if (handler->handle(sc)) {
+                    break;
+                }
+            }
+        }
+    }
+
+    this->world->updateActiveChunks(this->chunkActivationRange);
+
+    // Displace some object (almost) randomly
+    if (this->world->random(200) < 2) { // 1% chance of displacing an object
+        sim::profiling::ScopedTimer displacementTimer(this->profiler->getHistogram(sim::profiling::Phase::Displacement));
+        this->world->displaceObject();
+    }
+
+    // path queries see the doors as they are perceived in this iteration
+    this->pathPlanner->update();
+
+#ifdef SIM_DEBUG
+    std::cout << "[Simulator] Create and send perceptions..." << std::endl;
+#endif
+    // Produce and send perceptions for each robot
+    assert(this->simulatedAgents.size() < 5);
+    this->communication->sendWorldDelta(this->world);
+    for (auto& simulatedAgent : this->simulatedAgents) {
+        sim::profiling::ScopedTimer agentTimer(this->profiler->getPerceptionHistogram(simulatedAgent->getID()));
+        this->communication->sendSimPerceptions(simulatedAgent, this->world);
+        this->profiler->getAgentTelemetry().recordPerceptionSent(simulatedAgent->getID());
+    }
+    this->communication->sendPathResponses();
+    this->lastTickDuration = std::chrono::steady_clock::now() - tickStart;
+
+    this->tick++;
+    if (this->checkpointWriter && this->tick % this->checkpointInterval == 0) {
+        this->writeCheckpoint();
+    }
+}
+
+void Simulator::publishSnapshot()
+{
+    this->snapshotBuilder->build(this->world, *this->snapshot, this->tick);
+    viz::SimulatorStats& stats = this->snapshot->stats;
+    stats.tickTime = this->lastTickDuration;
+    stats.overruns = this->profiler->getOverruns();
+    stats.commands = this->profiler->getCommands();
+    stats.perceptionMessages = this->profiler->getPerceptionMessages();
+    stats.perceptionBytes = this->profiler->getPerceptionBytes();
+    stats.agents = this->simulatedAgents.size();
+    stats.activeChunks = this->world->getActiveChunkCount();
+    stats.residentChunks = this->world->getResidentChunkCount();
+    // the GUI is only created by run()
+    if (this->gui) {
+        this->gui->publish(*this->snapshot);
+    }
+    if (this->recorder && this->snapshot->tick % this->recordingInterval == 0) {
+        this->recorder->publish(*this->snapshot);
+    }
 }
 
 void Simulator::processSimCommand(srg::sim::containers::SimCommand sc)
 {
     std::lock_guard<std::recursive_mutex> guard(commandMutex);
+    this->enqueueSimCommand(sc);
+}
+
+void Simulator::processSimCommands(const std::vector<sim::containers::SimCommand>& simCommands)
+{
+    std::lock_guard<std::recursive_mutex> guard(commandMutex);
+    for (const sim::containers::SimCommand& sc : simCommands) {
+        this->enqueueSimCommand(sc);
+    }
+}
+
+/**
+ * Only one command per sender and iteration is accepted.
+ * Has to be called with the commandMutex locked.
+ */
+void Simulator::enqueueSimCommand(const sim::containers::SimCommand& sc)
+{
     for (auto& existingSc : this->commandQueue) {
         if (sc.senderID == existingSc.senderID) {
+            this->profiler->getAgentTelemetry().countDropped(sc.senderID);
             return;
         }
     }
     this->commandQueue.push_back(sc);
+    if (this->commandQueue.back().receiveTime.count() == 0) {
+        // not received via the communication, e.g., when embedded
+        this->commandQueue.back().receiveTime = std::chrono::system_clock::now().time_since_epoch();
+    }
 }
 
 bool Simulator::isRunning()
@@ -232,27 +501,3 @@ void Simulator::simSigintHandler(int sig)
 }
 
 } // namespace srg
-
-int main(int argc, char* argv[])
-{
-    bool headless = false;
-    if (argc > 1) {
-        if (std::string("--headless") == argv[1]) {
-            headless = true;
-        }
-    }
-
-    srg::Simulator* simulator = new srg::Simulator(headless);
-
-    signal(SIGINT, srg::Simulator::simSigintHandler);
-
-    simulator->start();
-
-    while (simulator->isRunning()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    }
-
-    delete simulator;
-
-    return 0;
-}
@@ -0,0 +1,42 @@
+#include "srg/Simulator.h"
+#include "srg/sim/profiling/TickProfiler.h"
+
+#include <chrono>
+#include <iostream>
+#include <signal.h>
+#include <string>
+#include <thread>
+
+int main(int argc, char* argv[])
+{
+    bool headless = false;
+    std::string checkpointFile;
+    for (int i = 1; i < argc; i++) {
+        if (std::string("--headless") == argv[i]) {
+            headless = true;
+        } else if (std::string("--restore") == argv[i] && i + 1 < argc) {
+            checkpointFile = argv[++i];
+        }
+    }
+
+    srg::Simulator* simulator = new srg::Simulator(headless);
+    if (!checkpointFile.empty() && !simulator->restore(checkpointFile)) {
+        std::cerr << "[SimulatorMain] Unable to restore '" << checkpointFile << "'!" << std::endl;
+        delete simulator;
+        return 1;
+    }
+
+    signal(SIGINT, srg::Simulator::simSigintHandler);
+    // dumps the profiling data on demand: kill -USR1 <pid>
+    signal(SIGUSR1, srg::sim::profiling::TickProfiler::requestDump);
+
+    simulator->start();
+
+    while (simulator->isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+
+    delete simulator;
+
+    return 0;
+}
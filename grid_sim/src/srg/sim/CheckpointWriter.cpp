@@ -0,0 +1,83 @@
+#include "srg/sim/CheckpointWriter.h"
+
+#include <essentials/FileSystem.h>
+
+#include <cstdio>
+#include <iostream>
+
+namespace srg
+{
+namespace sim
+{
+CheckpointWriter::CheckpointWriter(std::string directory)
+        : directory(directory)
+        , waiting(nullptr)
+        , running(true)
+        , writtenCheckpoints(0)
+        , droppedCheckpoints(0)
+{
+    if (!essentials::FileSystem::pathExists(this->directory)) {
+        essentials::FileSystem::createDirectory(this->directory, 755);
+    }
+    this->writerThread = new std::thread(&CheckpointWriter::writeLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        this->running = false;
+    }
+    this->condition.notify_all();
+    this->writerThread->join();
+    delete this->writerThread;
+    std::cout << "[CheckpointWriter] Wrote " << this->writtenCheckpoints << " checkpoints to " << this->directory << ", dropped "
+              << this->droppedCheckpoints << std::endl;
+}
+
+void CheckpointWriter::write(world::Checkpoint* checkpoint)
+{
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        if (this->waiting) {
+            delete this->waiting;
+            this->droppedCheckpoints++;
+        }
+        this->waiting = checkpoint;
+    }
+    this->condition.notify_one();
+}
+
+uint64_t CheckpointWriter::getWrittenCheckpoints() const
+{
+    return this->writtenCheckpoints;
+}
+
+uint64_t CheckpointWriter::getDroppedCheckpoints() const
+{
+    return this->droppedCheckpoints;
+}
+
+void CheckpointWriter::writeLoop()
+{
+    while (true) {
+        world::Checkpoint* checkpoint;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->condition.wait(lock, [this]() { return this->waiting || !this->running; });
+            if (!this->waiting) {
+                return;
+            }
+            checkpoint = this->waiting;
+            this->waiting = nullptr;
+        }
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "checkpoint_%08llu.srgcp", static_cast<unsigned long long>(checkpoint->tick));
+        if (checkpoint->write(essentials::FileSystem::combinePaths(this->directory, fileName))) {
+            this->writtenCheckpoints++;
+        }
+        delete checkpoint;
+    }
+}
+} // namespace sim
+} // namespace srg
@@ -1,21 +1,45 @@
 #include "srg/sim/ContainerUtils.h"
 
+#include "srg/sim/IDHandleRegistry.h"
+
+#include <srg/world/Cell.h>
+
 #include <essentials/IDManager.h>
 #include <essentials/WildcardID.h>
-#include <srg/sim/msgs/SimCommandMsg.capnp.h>
+
+#include <capnp/serialize-packed.h>
+#include <kj/io.h>
+#ifdef SRG_SIM_LZ4
+#include <lz4.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
 
 namespace srg
 {
 namespace sim
 {
-containers::SimCommand ContainerUtils::toSimCommand(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager)
+containers::SimCommand ContainerUtils::toSimCommand(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager, IDHandleRegistry* handles)
+{
+    return ContainerUtils::createSimCommand(msg.getRoot<srg::sim::SimCommandMsg>(), idManager, handles);
+}
+
+void ContainerUtils::toSimCommands(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager,
+        std::vector<containers::SimCommand>& simCommands, IDHandleRegistry* handles)
+{
+    srg::sim::SimCommandBatchMsg::Reader reader = msg.getRoot<srg::sim::SimCommandBatchMsg>();
+    simCommands.reserve(simCommands.size() + reader.getCommands().size());
+    for (srg::sim::SimCommandMsg::Reader simCommandReader : reader.getCommands()) {
+        simCommands.push_back(ContainerUtils::createSimCommand(simCommandReader, idManager, handles));
+    }
+}
+
+containers::SimCommand ContainerUtils::createSimCommand(srg::sim::SimCommandMsg::Reader reader, essentials::IDManager& idManager, IDHandleRegistry* handles)
 {
     containers::SimCommand sc;
-    srg::sim::SimCommandMsg::Reader reader = msg.getRoot<srg::sim::SimCommandMsg>();
-    sc.senderID = idManager.getIDFromBytes(
-            reader.getSenderID().getValue().asBytes().begin(), reader.getSenderID().getValue().size(), reader.getSenderID().getType());
-    sc.objectID = idManager.getIDFromBytes(
-            reader.getObjectID().getValue().asBytes().begin(), reader.getObjectID().getValue().size(), reader.getObjectID().getType());
+    sc.senderID = ContainerUtils::createID(reader.getSenderID(), reader.getSenderHandle(), idManager, handles);
+    sc.objectID = ContainerUtils::createID(reader.getObjectID(), reader.getObjectHandle(), idManager, handles);
     sc.timestamp = std::chrono::nanoseconds (reader.getTimestamp());
 
     switch (reader.getAction()) {
@@ -59,17 +83,43 @@ containers::SimCommand ContainerUtils::toSimCommand(::capnp::FlatArrayMessageRea
     return sc;
 }
 
-void ContainerUtils::toMsg(srg::sim::containers::SimCommand sc, ::capnp::MallocMessageBuilder& builder)
+void ContainerUtils::toMsg(srg::sim::containers::SimCommand sc, ::capnp::MallocMessageBuilder& builder, const IDHandleRegistry* handles)
 {
     SimCommandMsg::Builder msg = builder.getRoot<SimCommandMsg>();
+    ContainerUtils::toMsg(sc, msg, handles);
+}
+
+void ContainerUtils::toMsg(const std::vector<containers::SimCommand>& simCommands, ::capnp::MallocMessageBuilder& builder, const IDHandleRegistry* handles)
+{
+    SimCommandBatchMsg::Builder msg = builder.getRoot<SimCommandBatchMsg>();
+    msg.setTimestamp(std::chrono::system_clock::now().time_since_epoch().count());
+    ::capnp::List<::srg::sim::SimCommandMsg>::Builder commandsBuilder = msg.initCommands(simCommands.size());
+    for (unsigned int i = 0; i < simCommands.size(); i++) {
+        SimCommandMsg::Builder simCommandBuilder = commandsBuilder[i];
+        ContainerUtils::toMsg(simCommands[i], simCommandBuilder, handles);
+    }
+}
 
-    capnzero::ID::Builder senderID = msg.initSenderID();
-    senderID.setValue(kj::arrayPtr(sc.senderID->getRaw(), (unsigned int) sc.senderID->getSize()));
-    senderID.setType(sc.senderID->getType());
+void ContainerUtils::toMsg(const containers::SimCommand& sc, ::srg::sim::SimCommandMsg::Builder& msg, const IDHandleRegistry* handles)
+{
+    // IDs without a handle yet (e.g., of spawn commands) are sent in full
+    uint32_t senderHandle = handles ? handles->findHandle(sc.senderID) : IDHandleRegistry::NO_HANDLE;
+    if (senderHandle != IDHandleRegistry::NO_HANDLE) {
+        msg.setSenderHandle(senderHandle);
+    } else {
+        capnzero::ID::Builder senderID = msg.initSenderID();
+        senderID.setValue(kj::arrayPtr(sc.senderID->getRaw(), (unsigned int) sc.senderID->getSize()));
+        senderID.setType(sc.senderID->getType());
+    }
 
-    capnzero::ID::Builder objectID = msg.initObjectID();
-    objectID.setValue(kj::arrayPtr(sc.objectID->getRaw(), (unsigned int) sc.objectID->getSize()));
-    objectID.setType(sc.objectID->getType());
+    uint32_t objectHandle = handles ? handles->findHandle(sc.objectID) : IDHandleRegistry::NO_HANDLE;
+    if (objectHandle != IDHandleRegistry::NO_HANDLE) {
+        msg.setObjectHandle(objectHandle);
+    } else {
+        capnzero::ID::Builder objectID = msg.initObjectID();
+        objectID.setValue(kj::arrayPtr(sc.objectID->getRaw(), (unsigned int) sc.objectID->getSize()));
+        objectID.setType(sc.objectID->getType());
+    }
 
     msg.setTimestamp(sc.timestamp.count());
 
@@ -112,13 +162,14 @@ void ContainerUtils::toMsg(srg::sim::containers::SimCommand sc, ::capnp::MallocM
     msg.setY(sc.y);
 }
 
-containers::Perceptions ContainerUtils::toPerceptions(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager)
+containers::Perceptions ContainerUtils::toPerceptions(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager, IDHandleRegistry* handles)
 {
     srg::sim::PerceptionMsg::Reader reader = msg.getRoot<srg::sim::PerceptionMsg>();
-    return ContainerUtils::createPerceptions(reader, idManager);
+    return ContainerUtils::createPerceptions(reader, idManager, handles);
 }
 
-containers::Perceptions ContainerUtils::createPerceptions(srg::sim::PerceptionMsg::Reader perceptionsReader, essentials::IDManager& idManager)
+containers::Perceptions ContainerUtils::createPerceptions(
+        srg::sim::PerceptionMsg::Reader perceptionsReader, essentials::IDManager& idManager, IDHandleRegistry* handles)
 {
     containers::Perceptions ps;
 
@@ -131,7 +182,9 @@ containers::Perceptions ContainerUtils::createPerceptions(srg::sim::PerceptionMs
         cellPerception.y = cellPerceptionMsg.getY();
 
         for (srg::sim::PerceptionMsg::Object::Reader perceptionMsg : cellPerceptionMsg.getObjects()) {
-            cellPerception.objects.push_back(ContainerUtils::createObject(perceptionMsg, idManager));
+            if (std::shared_ptr<srg::world::Object> object = ContainerUtils::createObject(perceptionMsg, idManager, handles)) {
+                cellPerception.objects.push_back(object);
+            }
         }
         cellPerception.time = cellPerceptionMsg.getTime();
         ps.cellPerceptions.push_back(cellPerception);
@@ -139,7 +192,7 @@ containers::Perceptions ContainerUtils::createPerceptions(srg::sim::PerceptionMs
     return ps;
 }
 
-void ContainerUtils::toMsg(containers::Perceptions perceptions, ::srg::sim::PerceptionMsg::Builder& builder)
+void ContainerUtils::toMsg(const containers::Perceptions& perceptions, ::srg::sim::PerceptionMsg::Builder& builder)
 {
     capnzero::ID::Builder receiverID = builder.initReceiverID();
     receiverID.setValue(kj::arrayPtr(perceptions.receiverID->getRaw(), (unsigned int) perceptions.receiverID->getSize()));
@@ -159,61 +212,88 @@ void ContainerUtils::toMsg(containers::Perceptions perceptions, ::srg::sim::Perc
     }
 }
 
-std::shared_ptr<srg::world::Object> ContainerUtils::createObject(srg::sim::PerceptionMsg::Object::Reader& objectReader, essentials::IDManager& idManager)
+essentials::IdentifierConstPtr ContainerUtils::createID(
+        capnzero::ID::Reader idReader, uint32_t handle, essentials::IDManager& idManager, IDHandleRegistry* handles)
 {
-    // ID
-    essentials::IdentifierConstPtr id = idManager.getIDFromBytes(
-            objectReader.getId().getValue().asBytes().begin(), objectReader.getId().getValue().size(), objectReader.getId().getType());
-    // TYPE
-    srg::world::ObjectType type;
-    switch (objectReader.getType()) {
+    if (handle == IDHandleRegistry::NO_HANDLE) {
+        return idManager.getIDFromBytes(idReader.getValue().asBytes().begin(), idReader.getValue().size(), idReader.getType());
+    }
+    if (!handles) {
+        std::cerr << "[ContainerUtils] Received ID handle " << handle << " without an IDHandleRegistry!" << std::endl;
+        return nullptr;
+    }
+    // unknown handles are remembered by the registry, so their mapping can be requested
+    return handles->getID(handle);
+}
+
+srg::world::ObjectType ContainerUtils::toObjectType(srg::sim::PerceptionMsg::Object::Type type)
+{
+    srg::world::ObjectType objectType = srg::world::ObjectType::Unknown;
+    switch (type) {
     case srg::sim::PerceptionMsg::Object::Type::ROBOT:
-        type = srg::world::ObjectType::Robot;
+        objectType = srg::world::ObjectType::Robot;
         break;
     case srg::sim::PerceptionMsg::Object::Type::HUMAN:
-        type = srg::world::ObjectType::Human;
+        objectType = srg::world::ObjectType::Human;
         break;
     case srg::sim::PerceptionMsg::Object::Type::DOOR:
-        type = srg::world::ObjectType::Door;
+        objectType = srg::world::ObjectType::Door;
         break;
     case srg::sim::PerceptionMsg::Object::Type::CUPRED:
-        type = srg::world::ObjectType::CupRed;
+        objectType = srg::world::ObjectType::CupRed;
         break;
     case srg::sim::PerceptionMsg::Object::Type::CUPBLUE:
-        type = srg::world::ObjectType::CupBlue;
+        objectType = srg::world::ObjectType::CupBlue;
         break;
     case srg::sim::PerceptionMsg::Object::Type::CUPYELLOW:
-        type = srg::world::ObjectType::CupYellow;
+        objectType = srg::world::ObjectType::CupYellow;
         break;
     default:
         std::cerr << "[ContainterUtils] Unknown object type in capnp message found!" << std::endl;
         break;
     }
+    return objectType;
+}
 
-    // STATE
-    srg::world::ObjectState state;
-    switch (objectReader.getState()) {
+srg::world::ObjectState ContainerUtils::toObjectState(srg::sim::PerceptionMsg::Object::State state)
+{
+    srg::world::ObjectState objectState = srg::world::ObjectState::Undefined;
+    switch (state) {
     case srg::sim::PerceptionMsg::Object::State::OPEN:
-        state = srg::world::ObjectState::Open;
+        objectState = srg::world::ObjectState::Open;
         break;
     case srg::sim::PerceptionMsg::Object::State::CLOSED:
-        state = srg::world::ObjectState::Closed;
+        objectState = srg::world::ObjectState::Closed;
         break;
     case srg::sim::PerceptionMsg::Object::State::UNDEFINED:
-        state = srg::world::ObjectState::Undefined;
+        objectState = srg::world::ObjectState::Undefined;
         break;
     default:
-        std::cerr << "[ContainterUtils] Unknown object type in capnp message found!" << std::endl;
+        std::cerr << "[ContainterUtils] Unknown object state in capnp message found!" << std::endl;
         break;
     }
-    std::shared_ptr<srg::world::Object> object = std::make_shared<srg::world::Object>(id, type, state);
+    return objectState;
+}
+
+std::shared_ptr<srg::world::Object> ContainerUtils::createObject(
+        srg::sim::PerceptionMsg::Object::Reader& objectReader, essentials::IDManager& idManager, IDHandleRegistry* handles)
+{
+    // ID
+    essentials::IdentifierConstPtr id = ContainerUtils::createID(objectReader.getId(), objectReader.getHandle(), idManager, handles);
+    if (!id) {
+        return nullptr;
+    }
+    std::shared_ptr<srg::world::Object> object =
+            std::make_shared<srg::world::Object>(id, ContainerUtils::toObjectType(objectReader.getType()), ContainerUtils::toObjectState(objectReader.getState()));
     for (srg::sim::PerceptionMsg::Object::Reader childObjectReader : objectReader.getObjects()) {
-        object->addObject(ContainerUtils::createObject(childObjectReader, idManager));
+        if (std::shared_ptr<srg::world::Object> childObject = ContainerUtils::createObject(childObjectReader, idManager, handles)) {
+            object->addObject(childObject);
+        }
     }
     return object;
 }
 
-void ContainerUtils::toMsg(srg::sim::containers::Perceptions sp, ::capnp::MallocMessageBuilder& builder)
+void ContainerUtils::toMsg(const srg::sim::containers::Perceptions& sp, ::capnp::MallocMessageBuilder& builder)
 {
     PerceptionMsg::Builder msg = builder.getRoot<PerceptionMsg>();
 
@@ -235,60 +315,474 @@ void ContainerUtils::toMsg(srg::sim::containers::Perceptions sp, ::capnp::Malloc
 }
 
 void ContainerUtils::toObjectListMsg(
-        std::vector<std::shared_ptr<srg::world::Object>>& objects, ::capnp::List<::srg::sim::PerceptionMsg::Object>::Builder& objectsListBuilder)
+        const std::vector<std::shared_ptr<srg::world::Object>>& objects, ::capnp::List<::srg::sim::PerceptionMsg::Object>::Builder& objectsListBuilder)
 {
     for (unsigned int j = 0; j < objects.size(); j++) {
         srg::sim::PerceptionMsg::Object::Builder objectBuilder = objectsListBuilder[j];
-        ::capnp::List<::srg::sim::PerceptionMsg::Object>::Builder childObjectsListBuilder = objectBuilder.initObjects(objects[j]->getObjects().size());
-        if (objects[j]->getObjects().size() > 0) {
-            std::vector<std::shared_ptr<srg::world::Object>> childObject;
-            for (auto& objectEntry : objects[j]->getObjects()) {
-                childObject.push_back(objectEntry.second);
+        ContainerUtils::toMsg(*objects[j], objectBuilder);
+    }
+}
+
+void ContainerUtils::toMsg(const srg::world::Object& object, ::srg::sim::PerceptionMsg::Object::Builder& objectBuilder, IDHandleRegistry* handles)
+{
+    // child objects are written directly from the object set, without collecting them first
+    ::capnp::List<::srg::sim::PerceptionMsg::Object>::Builder childObjectsListBuilder = objectBuilder.initObjects(object.getObjects().size());
+    unsigned int childIdx = 0;
+    for (auto& objectEntry : object.getObjects()) {
+        srg::sim::PerceptionMsg::Object::Builder childObjectBuilder = childObjectsListBuilder[childIdx++];
+        ContainerUtils::toMsg(*objectEntry.second, childObjectBuilder, handles);
+    }
+
+    switch (object.getType()) {
+    case srg::world::ObjectType::Robot:
+        objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::ROBOT);
+        break;
+    case srg::world::ObjectType::Human:
+        objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::HUMAN);
+        break;
+    case srg::world::ObjectType::CupRed:
+        objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::CUPRED);
+        break;
+    case srg::world::ObjectType::CupBlue:
+        objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::CUPBLUE);
+        break;
+    case srg::world::ObjectType::CupYellow:
+        objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::CUPYELLOW);
+        break;
+    case srg::world::ObjectType::Door:
+        objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::DOOR);
+        break;
+    default:
+        std::cerr << "[ContainterUtils] Unknown object type perceived: " << object.getType() << std::endl;
+        break;
+    }
+    switch (object.getState()) {
+    case srg::world::ObjectState::Open:
+        objectBuilder.setState(srg::sim::PerceptionMsg::Object::State::OPEN);
+        break;
+    case srg::world::ObjectState::Closed:
+        objectBuilder.setState(srg::sim::PerceptionMsg::Object::State::CLOSED);
+        break;
+    case srg::world::ObjectState::Undefined:
+        objectBuilder.setState(srg::sim::PerceptionMsg::Object::State::UNDEFINED);
+        break;
+    default:
+        std::cerr << "[ContainterUtils] Unknown object state perceived: " << object.getState() << std::endl;
+        break;
+    }
+    if (handles) {
+        objectBuilder.setHandle(handles->getHandle(object.getID()));
+        return;
+    }
+    capnzero::ID::Builder objectID = objectBuilder.initId();
+    objectID.setType(object.getID()->getType());
+    objectID.setValue(::capnp::Data::Reader(object.getID()->getRaw(), object.getID()->getSize()));
+}
+
+void ContainerUtils::toMsg(essentials::IdentifierConstPtr receiverID, std::chrono::system_clock::duration timestamp,
+        const std::vector<const srg::world::Cell*>& cells, ::srg::sim::PerceptionMsg::Builder& builder, IDHandleRegistry* handles)
+{
+    capnzero::ID::Builder receiverIDBuilder = builder.initReceiverID();
+    receiverIDBuilder.setValue(kj::arrayPtr(receiverID->getRaw(), (unsigned int) receiverID->getSize()));
+    receiverIDBuilder.setType(receiverID->getType());
+
+    builder.setTimestamp(timestamp.count());
+
+    int64_t time = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(timestamp).count();
+    ::capnp::List<::srg::sim::PerceptionMsg::CellPerception>::Builder cellPerceptionsListBuilder = builder.initCellPerceptions(cells.size());
+    for (unsigned int i = 0; i < cells.size(); i++) {
+        ::srg::sim::PerceptionMsg::CellPerception::Builder cellPerceptionBuilder = cellPerceptionsListBuilder[i];
+        cellPerceptionBuilder.setTime(time);
+        cellPerceptionBuilder.setX(cells[i]->coordinate.x);
+        cellPerceptionBuilder.setY(cells[i]->coordinate.y);
+        ::capnp::List<::srg::sim::PerceptionMsg::Object>::Builder objectListBuilder = cellPerceptionBuilder.initObjects(cells[i]->getObjects().size());
+        unsigned int objectIdx = 0;
+        for (auto& objectEntry : cells[i]->getObjects()) {
+            srg::sim::PerceptionMsg::Object::Builder objectBuilder = objectListBuilder[objectIdx++];
+            ContainerUtils::toMsg(*objectEntry.second, objectBuilder, handles);
+        }
+    }
+}
+template <class VisibilityBuilder>
+void ContainerUtils::toVisibilityMsg(const std::vector<const srg::world::Cell*>& cells, VisibilityBuilder& builder)
+{
+    if (cells.empty()) {
+        return;
+    }
+
+    // bounding box of the visible cells
+    int32_t minX = cells.front()->coordinate.x;
+    int32_t maxX = minX;
+    int32_t minY = cells.front()->coordinate.y;
+    int32_t maxY = minY;
+    for (const srg::world::Cell* cell : cells) {
+        minX = std::min(minX, cell->coordinate.x);
+        maxX = std::max(maxX, cell->coordinate.x);
+        minY = std::min(minY, cell->coordinate.y);
+        maxY = std::max(maxY, cell->coordinate.y);
+    }
+    uint32_t width = maxX - minX + 1;
+    uint32_t height = maxY - minY + 1;
+    builder.setOriginX(minX);
+    builder.setOriginY(minY);
+    builder.setWidth(width);
+    builder.setHeight(height);
+
+    ::capnp::Data::Builder visibility = builder.initVisibility((width * height + 7) / 8);
+    for (const srg::world::Cell* cell : cells) {
+        uint32_t index = (cell->coordinate.y - minY) * width + (cell->coordinate.x - minX);
+        visibility[index / 8] |= (1 << (index % 8));
+    }
+}
+
+void ContainerUtils::toMsg(essentials::IdentifierConstPtr receiverID, std::chrono::system_clock::duration timestamp,
+        const std::vector<const srg::world::Cell*>& cells, ::srg::sim::CompactPerceptionMsg::Builder& builder, IDHandleRegistry* handles)
+{
+    capnzero::ID::Builder receiverIDBuilder = builder.initReceiverID();
+    receiverIDBuilder.setValue(kj::arrayPtr(receiverID->getRaw(), (unsigned int) receiverID->getSize()));
+    receiverIDBuilder.setType(receiverID->getType());
+    builder.setTimestamp(timestamp.count());
+
+    ContainerUtils::toVisibilityMsg(cells, builder);
+
+    // the cells are ordered by x, but the decoders step through the object cells by their row-major index
+    std::vector<std::pair<uint32_t, const srg::world::Cell*>> objectCells;
+    for (const srg::world::Cell* cell : cells) {
+        if (!cell->getObjects().empty()) {
+            objectCells.emplace_back((cell->coordinate.y - builder.getOriginY()) * builder.getWidth() + (cell->coordinate.x - builder.getOriginX()), cell);
+        }
+    }
+    std::sort(objectCells.begin(), objectCells.end(),
+            [](const std::pair<uint32_t, const srg::world::Cell*>& first, const std::pair<uint32_t, const srg::world::Cell*>& second) {
+                return first.first < second.first;
+            });
+
+    ::capnp::List<::srg::sim::CompactPerceptionMsg::ObjectCell>::Builder objectCellsBuilder = builder.initObjectCells(objectCells.size());
+    uint32_t objectCellIdx = 0;
+    for (auto& objectCell : objectCells) {
+        ::srg::sim::CompactPerceptionMsg::ObjectCell::Builder objectCellBuilder = objectCellsBuilder[objectCellIdx++];
+        objectCellBuilder.setIndex(objectCell.first);
+        ::capnp::List<::srg::sim::PerceptionMsg::Object>::Builder objectListBuilder = objectCellBuilder.initObjects(objectCell.second->getObjects().size());
+        unsigned int objectIdx = 0;
+        for (auto& objectEntry : objectCell.second->getObjects()) {
+            srg::sim::PerceptionMsg::Object::Builder objectBuilder = objectListBuilder[objectIdx++];
+            ContainerUtils::toMsg(*objectEntry.second, objectBuilder, handles);
+        }
+    }
+}
+
+containers::Perceptions ContainerUtils::toCompactPerceptions(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager, IDHandleRegistry* handles)
+{
+    srg::sim::CompactPerceptionMsg::Reader reader = msg.getRoot<srg::sim::CompactPerceptionMsg>();
+    return ContainerUtils::createPerceptions(reader, idManager, handles);
+}
+
+containers::Perceptions ContainerUtils::createPerceptions(
+        srg::sim::CompactPerceptionMsg::Reader perceptionsReader, essentials::IDManager& idManager, IDHandleRegistry* handles)
+{
+    containers::Perceptions ps;
+    ps.receiverID = idManager.getIDFromBytes(perceptionsReader.getReceiverID().getValue().asBytes().begin(),
+            perceptionsReader.getReceiverID().getValue().size(), perceptionsReader.getReceiverID().getType());
+    ps.timestamp = std::chrono::nanoseconds(perceptionsReader.getTimestamp());
+    int64_t time = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(ps.timestamp).count();
+
+    uint32_t width = perceptionsReader.getWidth();
+    uint32_t cellCount = width * perceptionsReader.getHeight();
+    ::capnp::Data::Reader visibility = perceptionsReader.getVisibility();
+    ::capnp::List<::srg::sim::CompactPerceptionMsg::ObjectCell>::Reader objectCells = perceptionsReader.getObjectCells();
+    unsigned int objectCellIdx = 0;
+    for (uint32_t index = 0; index < cellCount && index / 8 < visibility.size(); index++) {
+        if (!(visibility[index / 8] & (1 << (index % 8)))) {
+            continue;
+        }
+        srg::sim::containers::CellPerception cellPerception;
+        cellPerception.x = perceptionsReader.getOriginX() + index % width;
+        cellPerception.y = perceptionsReader.getOriginY() + index / width;
+        cellPerception.time = time;
+        while (objectCellIdx < objectCells.size() && objectCells[objectCellIdx].getIndex() < index) {
+            objectCellIdx++;
+        }
+        if (objectCellIdx < objectCells.size() && objectCells[objectCellIdx].getIndex() == index) {
+            for (srg::sim::PerceptionMsg::Object::Reader objectReader : objectCells[objectCellIdx].getObjects()) {
+                if (std::shared_ptr<srg::world::Object> object = ContainerUtils::createObject(objectReader, idManager, handles)) {
+                    cellPerception.objects.push_back(object);
+                }
             }
-            ContainerUtils::toObjectListMsg(childObject, childObjectsListBuilder);
         }
+        ps.cellPerceptions.push_back(cellPerception);
+    }
+
+    // the version 1 message is ordered by x first
+    std::sort(ps.cellPerceptions.begin(), ps.cellPerceptions.end(), [](const containers::CellPerception& first, const containers::CellPerception& second) {
+        return first.x < second.x || (first.x == second.x && first.y < second.y);
+    });
+    return ps;
+}
+
+bool ContainerUtils::isFramingSupported(::srg::sim::FramedMsg::Framing framing)
+{
+    switch (framing) {
+    case srg::sim::FramedMsg::Framing::NONE:
+    case srg::sim::FramedMsg::Framing::PACKED:
+        return true;
+    case srg::sim::FramedMsg::Framing::LZ4:
+#ifdef SRG_SIM_LZ4
+        return true;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+void ContainerUtils::frame(
+        ::srg::sim::FramedMsg::Framing framing, ::capnp::MessageBuilder& payload, std::vector<kj::byte>& buffer, ::srg::sim::FramedMsg::Builder& builder)
+{
+    size_t size = ::capnp::computeSerializedSizeInWords(payload) * sizeof(::capnp::word);
+    builder.setSize(size);
+    switch (framing) {
+    case srg::sim::FramedMsg::Framing::PACKED: {
+        // worst case: one tag byte per word plus run length bytes
+        buffer.resize(size + size / 8 + 16);
+        kj::ArrayOutputStream output(kj::arrayPtr(buffer.data(), buffer.size()));
+        ::capnp::writePackedMessage(output, payload);
+        builder.setFraming(srg::sim::FramedMsg::Framing::PACKED);
+        builder.setPayload(output.getArray());
+        return;
+    }
+#ifdef SRG_SIM_LZ4
+    case srg::sim::FramedMsg::Framing::LZ4: {
+        // the serialized message and its compressed version share the buffer
+        int bound = LZ4_compressBound(size);
+        buffer.resize(size + bound);
+        kj::ArrayOutputStream output(kj::arrayPtr(buffer.data(), size));
+        ::capnp::writeMessage(output, payload);
+        int compressedSize = LZ4_compress_default(
+                reinterpret_cast<const char*>(buffer.data()), reinterpret_cast<char*>(buffer.data() + size), size, bound);
+        if (compressedSize > 0) {
+            builder.setFraming(srg::sim::FramedMsg::Framing::LZ4);
+            builder.setPayload(kj::arrayPtr(buffer.data() + size, compressedSize));
+            return;
+        }
+        std::cerr << "[ContainerUtils] LZ4 compression failed, sending uncompressed!" << std::endl;
+        builder.setFraming(srg::sim::FramedMsg::Framing::NONE);
+        builder.setPayload(kj::arrayPtr(buffer.data(), size));
+        return;
+    }
+#endif
+    default: {
+        buffer.resize(size);
+        kj::ArrayOutputStream output(kj::arrayPtr(buffer.data(), buffer.size()));
+        ::capnp::writeMessage(output, payload);
+        builder.setFraming(srg::sim::FramedMsg::Framing::NONE);
+        builder.setPayload(output.getArray());
+    }
+    }
+}
+
+kj::Array<::capnp::word> ContainerUtils::unframe(::srg::sim::FramedMsg::Reader framedReader)
+{
+    ::capnp::Data::Reader payload = framedReader.getPayload();
+    // the declared size is checked against the received payload before allocating for it, packing turns at most
+    // 2 bytes into 256 zero words and LZ4 expands by at most 255 times
+    uint64_t maxSize = framedReader.getSize();
+    if (framedReader.getFraming() == srg::sim::FramedMsg::Framing::PACKED) {
+        maxSize = uint64_t(payload.size()) * 256 * sizeof(::capnp::word) / 2;
+    } else if (framedReader.getFraming() == srg::sim::FramedMsg::Framing::LZ4) {
+        maxSize = uint64_t(payload.size()) * 255;
+    }
+    if (framedReader.getSize() > maxSize || framedReader.getSize() % sizeof(::capnp::word) != 0) {
+        std::cerr << "[ContainerUtils] Framed message declares " << framedReader.getSize() << " bytes for a payload of " << payload.size()
+                  << " bytes!" << std::endl;
+        return nullptr;
+    }
+    switch (framedReader.getFraming()) {
+    case srg::sim::FramedMsg::Framing::NONE: {
+        // copy for proper alignment
+        kj::Array<::capnp::word> words = kj::heapArray<::capnp::word>((payload.size() + sizeof(::capnp::word) - 1) / sizeof(::capnp::word));
+        memcpy(words.begin(), payload.begin(), payload.size());
+        return words;
+    }
+    case srg::sim::FramedMsg::Framing::PACKED: {
+        kj::Array<::capnp::word> words = kj::heapArray<::capnp::word>(framedReader.getSize() / sizeof(::capnp::word));
+        kj::ArrayInputStream input(payload);
+        ::capnp::_::PackedInputStream packedInput(input);
+        packedInput.read(words.begin(), words.size() * sizeof(::capnp::word));
+        return words;
+    }
+    case srg::sim::FramedMsg::Framing::LZ4: {
+#ifdef SRG_SIM_LZ4
+        kj::Array<::capnp::word> words = kj::heapArray<::capnp::word>(framedReader.getSize() / sizeof(::capnp::word));
+        int size = LZ4_decompress_safe(
+                reinterpret_cast<const char*>(payload.begin()), reinterpret_cast<char*>(words.begin()), payload.size(), framedReader.getSize());
+        if (size != static_cast<int>(framedReader.getSize())) {
+            std::cerr << "[ContainerUtils] LZ4 decompression failed!" << std::endl;
+            return nullptr;
+        }
+        return words;
+#else
+        std::cerr << "[ContainerUtils] Received LZ4 compressed message, but compiled without LZ4 support!" << std::endl;
+        return nullptr;
+#endif
+    }
+    default:
+        std::cerr << "[ContainerUtils] Unknown framing in capnp message found!" << std::endl;
+        return nullptr;
+    }
+}
+
+void ContainerUtils::toMsg(uint64_t tick, std::chrono::system_clock::duration timestamp, bool keyframe,
+        const std::vector<const srg::world::Cell*>& cells, ::srg::sim::WorldDeltaMsg::Builder& builder, IDHandleRegistry* handles)
+{
+    builder.setTick(tick);
+    builder.setTimestamp(timestamp.count());
+    builder.setKeyframe(keyframe);
+    ::capnp::List<::srg::sim::WorldDeltaMsg::CellUpdate>::Builder cellsBuilder = builder.initCells(cells.size());
+    for (unsigned int i = 0; i < cells.size(); i++) {
+        ::srg::sim::WorldDeltaMsg::CellUpdate::Builder cellBuilder = cellsBuilder[i];
+        cellBuilder.setX(cells[i]->coordinate.x);
+        cellBuilder.setY(cells[i]->coordinate.y);
+        ::capnp::List<::srg::sim::PerceptionMsg::Object>::Builder objectListBuilder = cellBuilder.initObjects(cells[i]->getObjects().size());
+        unsigned int objectIdx = 0;
+        for (auto& objectEntry : cells[i]->getObjects()) {
+            srg::sim::PerceptionMsg::Object::Builder objectBuilder = objectListBuilder[objectIdx++];
+            ContainerUtils::toMsg(*objectEntry.second, objectBuilder, handles);
+        }
+    }
+}
 
-        switch (objects[j]->getType()) {
-        case srg::world::ObjectType::Robot:
-            objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::ROBOT);
-            break;
-        case srg::world::ObjectType::Human:
-            objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::HUMAN);
-            break;
-        case srg::world::ObjectType::CupRed:
-            objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::CUPRED);
-            break;
-        case srg::world::ObjectType::CupBlue:
-            objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::CUPBLUE);
-            break;
-        case srg::world::ObjectType::CupYellow:
-            objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::CUPYELLOW);
-            break;
-        case srg::world::ObjectType::Door:
-            objectBuilder.setType(srg::sim::PerceptionMsg::Object::Type::DOOR);
-            break;
-        default:
-            std::cerr << "[ContainterUtils] Unknown object type perceived: " << objects[j]->getType() << std::endl;
-            break;
+void ContainerUtils::toMsg(essentials::IdentifierConstPtr receiverID, uint64_t tick, std::chrono::system_clock::duration timestamp,
+        const std::vector<const srg::world::Cell*>& cells, ::srg::sim::VisibilityMsg::Builder& builder)
+{
+    capnzero::ID::Builder receiverIDBuilder = builder.initReceiverID();
+    receiverIDBuilder.setValue(kj::arrayPtr(receiverID->getRaw(), (unsigned int) receiverID->getSize()));
+    receiverIDBuilder.setType(receiverID->getType());
+    builder.setTick(tick);
+    builder.setTimestamp(timestamp.count());
+    ContainerUtils::toVisibilityMsg(cells, builder);
+}
+
+void ContainerUtils::toMsg(const std::vector<uint32_t>& announcedHandles, IDHandleRegistry& handles, ::srg::sim::IDMappingMsg::Builder& builder)
+{
+    ::capnp::List<::srg::sim::IDMappingMsg::Mapping>::Builder mappingsBuilder = builder.initMappings(announcedHandles.size());
+    for (unsigned int i = 0; i < announcedHandles.size(); i++) {
+        ::srg::sim::IDMappingMsg::Mapping::Builder mappingBuilder = mappingsBuilder[i];
+        mappingBuilder.setHandle(announcedHandles[i]);
+        essentials::IdentifierConstPtr id = handles.getID(announcedHandles[i]);
+        if (!id) {
+            continue;
         }
-        switch (objects[j]->getState()) {
-        case srg::world::ObjectState::Open:
-            objectBuilder.setState(srg::sim::PerceptionMsg::Object::State::OPEN);
-            break;
-        case srg::world::ObjectState::Closed:
-            objectBuilder.setState(srg::sim::PerceptionMsg::Object::State::CLOSED);
-            break;
-        case srg::world::ObjectState::Undefined:
-            objectBuilder.setState(srg::sim::PerceptionMsg::Object::State::UNDEFINED);
-            break;
-        default:
-            std::cerr << "[ContainterUtils] Unknown object state perceived: " << objects[j]->getState() << std::endl;
-            break;
+        capnzero::ID::Builder idBuilder = mappingBuilder.initId();
+        idBuilder.setType(id->getType());
+        idBuilder.setValue(::capnp::Data::Reader(id->getRaw(), id->getSize()));
+    }
+}
+
+void ContainerUtils::applyMapping(::srg::sim::IDMappingMsg::Reader mappingReader, essentials::IDManager& idManager, IDHandleRegistry& handles)
+{
+    for (::srg::sim::IDMappingMsg::Mapping::Reader mapping : mappingReader.getMappings()) {
+        if (!mapping.hasId()) {
+            continue;
         }
-        capnzero::ID::Builder objectID = objectBuilder.initId();
-        objectID.setType(objects[j]->getID()->getType());
-        objectID.setValue(::capnp::Data::Reader(objects[j]->getID()->getRaw(), objects[j]->getID()->getSize()));
+        handles.setMapping(mapping.getHandle(),
+                idManager.getIDFromBytes(mapping.getId().getValue().asBytes().begin(), mapping.getId().getValue().size(), mapping.getId().getType()));
+    }
+}
+
+containers::PathQuery ContainerUtils::toPathQuery(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager, IDHandleRegistry* handles)
+{
+    PathQueryMsg::Reader reader = msg.getRoot<PathQueryMsg>();
+    containers::PathQuery query;
+    query.requestID = reader.getRequestID();
+    query.senderID = ContainerUtils::createID(reader.getSenderID(), reader.getSenderHandle(), idManager, handles);
+    query.fromX = reader.getFromX();
+    query.fromY = reader.getFromY();
+    query.toX = reader.getToX();
+    query.toY = reader.getToY();
+    query.maxExpansions = reader.getMaxExpansions();
+    query.timestamp = std::chrono::nanoseconds(reader.getTimestamp());
+    return query;
+}
+
+void ContainerUtils::toMsg(const containers::PathQuery& query, ::srg::sim::PathQueryMsg::Builder& builder, const IDHandleRegistry* handles)
+{
+    builder.setRequestID(query.requestID);
+    uint32_t senderHandle = handles ? handles->findHandle(query.senderID) : IDHandleRegistry::NO_HANDLE;
+    if (senderHandle != IDHandleRegistry::NO_HANDLE) {
+        builder.setSenderHandle(senderHandle);
+    } else {
+        capnzero::ID::Builder senderID = builder.initSenderID();
+        senderID.setValue(kj::arrayPtr(query.senderID->getRaw(), (unsigned int) query.senderID->getSize()));
+        senderID.setType(query.senderID->getType());
+    }
+    builder.setFromX(query.fromX);
+    builder.setFromY(query.fromY);
+    builder.setToX(query.toX);
+    builder.setToY(query.toY);
+    builder.setMaxExpansions(query.maxExpansions);
+    builder.setTimestamp(query.timestamp.count());
+}
+
+containers::PathResult ContainerUtils::toPathResult(::capnp::FlatArrayMessageReader& msg, essentials::IDManager& idManager)
+{
+    PathResponseMsg::Reader reader = msg.getRoot<PathResponseMsg>();
+    containers::PathResult result;
+    result.requestID = reader.getRequestID();
+    result.receiverID = idManager.getIDFromBytes(
+            reader.getReceiverID().getValue().asBytes().begin(), reader.getReceiverID().getValue().size(), reader.getReceiverID().getType());
+    switch (reader.getStatus()) {
+    case PathResponseMsg::Status::FOUND:
+        result.status = containers::PathResult::Status::Found;
+        break;
+    case PathResponseMsg::Status::NO_PATH:
+        result.status = containers::PathResult::Status::NoPath;
+        break;
+    case PathResponseMsg::Status::EXPANSION_LIMIT:
+        result.status = containers::PathResult::Status::ExpansionLimit;
+        break;
+    default:
+        result.status = containers::PathResult::Status::Invalid;
+    }
+    result.path.reserve(reader.getPath().size());
+    for (PathResponseMsg::Point::Reader point : reader.getPath()) {
+        result.path.emplace_back(point.getX(), point.getY());
+    }
+    result.expansions = reader.getExpansions();
+    result.latency = std::chrono::nanoseconds(reader.getLatency());
+    result.timestamp = std::chrono::nanoseconds(reader.getTimestamp());
+    return result;
+}
+
+void ContainerUtils::toMsg(const containers::PathResult& result, ::srg::sim::PathResponseMsg::Builder& builder)
+{
+    builder.setRequestID(result.requestID);
+    if (result.receiverID) {
+        capnzero::ID::Builder receiverID = builder.initReceiverID();
+        receiverID.setValue(kj::arrayPtr(result.receiverID->getRaw(), (unsigned int) result.receiverID->getSize()));
+        receiverID.setType(result.receiverID->getType());
+    }
+    switch (result.status) {
+    case containers::PathResult::Status::Found:
+        builder.setStatus(PathResponseMsg::Status::FOUND);
+        break;
+    case containers::PathResult::Status::NoPath:
+        builder.setStatus(PathResponseMsg::Status::NO_PATH);
+        break;
+    case containers::PathResult::Status::ExpansionLimit:
+        builder.setStatus(PathResponseMsg::Status::EXPANSION_LIMIT);
+        break;
+    default:
+        builder.setStatus(PathResponseMsg::Status::INVALID);
+    }
+    ::capnp::List<PathResponseMsg::Point>::Builder pathBuilder = builder.initPath(result.path.size());
+    for (unsigned int i = 0; i < result.path.size(); i++) {
+        pathBuilder[i].setX(result.path[i].first);
+        pathBuilder[i].setY(result.path[i].second);
     }
+    builder.setExpansions(result.expansions);
+    builder.setLatency(result.latency.count());
+    builder.setTimestamp(result.timestamp.count());
 }
 } // namespace sim
 } // namespace srg
\ No newline at end of file
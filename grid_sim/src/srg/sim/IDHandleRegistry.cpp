@@ -0,0 +1,86 @@
+#include "srg/sim/IDHandleRegistry.h"
+
+namespace srg
+{
+namespace sim
+{
+const uint32_t IDHandleRegistry::NO_HANDLE;
+
+IDHandleRegistry::IDHandleRegistry()
+        : ids(1, nullptr)
+        , announcedHandles(1)
+{
+}
+
+uint32_t IDHandleRegistry::getHandle(essentials::IdentifierConstPtr id)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    auto handleEntry = this->handles.find(id);
+    if (handleEntry != this->handles.end()) {
+        return handleEntry->second;
+    }
+    uint32_t handle = this->ids.size();
+    this->ids.push_back(id);
+    this->handles.emplace(id, handle);
+    return handle;
+}
+
+uint32_t IDHandleRegistry::findHandle(essentials::IdentifierConstPtr id) const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    auto handleEntry = this->handles.find(id);
+    if (handleEntry == this->handles.end()) {
+        return NO_HANDLE;
+    }
+    return handleEntry->second;
+}
+
+essentials::IdentifierConstPtr IDHandleRegistry::getID(uint32_t handle)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    if (handle < this->ids.size() && this->ids[handle]) {
+        return this->ids[handle];
+    }
+    if (handle != NO_HANDLE) {
+        this->missingHandles.insert(handle);
+    }
+    return nullptr;
+}
+
+void IDHandleRegistry::setMapping(uint32_t handle, essentials::IdentifierConstPtr id)
+{
+    if (handle == NO_HANDLE || !id) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(this->mutex);
+    if (handle >= this->ids.size()) {
+        this->ids.resize(handle + 1, nullptr);
+    }
+    this->ids[handle] = id;
+    this->handles[id] = handle;
+    this->missingHandles.erase(handle);
+}
+
+uint32_t IDHandleRegistry::getHandleCount() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->ids.size() - 1;
+}
+
+void IDHandleRegistry::takeUnannounced(std::vector<uint32_t>& handles)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    for (uint32_t handle = this->announcedHandles; handle < this->ids.size(); handle++) {
+        handles.push_back(handle);
+    }
+    this->announcedHandles = this->ids.size();
+}
+
+void IDHandleRegistry::takeMissing(std::vector<uint32_t>& handles)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    handles.insert(handles.end(), this->missingHandles.begin(), this->missingHandles.end());
+    this->missingHandles.clear();
+}
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,310 @@
+#include "srg/sim/PathPlanner.h"
+
+#include <srg/World.h>
+#include <srg/world/Cell.h>
+#include <srg/world/Coordinate.h>
+#include <srg/world/Object.h>
+#include <srg/world/RoomGraph.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace srg
+{
+namespace sim
+{
+namespace
+{
+struct OpenNode
+{
+    uint32_t f;
+    uint32_t h;
+    uint32_t index;
+};
+
+/**
+ * Orders the binary heap by the smallest estimate, ties by the smallest remaining distance.
+ */
+bool operator<(const OpenNode& a, const OpenNode& b)
+{
+    return a.f > b.f || (a.f == b.f && a.h > b.h);
+}
+
+/**
+ * Search arrays of one thread, reused over its queries. Entries are only valid if their stamp
+ * matches the current search, so nothing has to be cleared between queries.
+ */
+struct SearchSpace
+{
+    SearchSpace()
+            : search(0)
+    {
+    }
+
+    void begin(size_t cellCount)
+    {
+        if (this->seen.size() < cellCount) {
+            this->seen.resize(cellCount, 0);
+            this->closed.resize(cellCount, 0);
+            this->cost.resize(cellCount);
+            this->parent.resize(cellCount);
+        }
+        if (++this->search == std::numeric_limits<uint32_t>::max()) {
+            std::fill(this->seen.begin(), this->seen.end(), 0);
+            std::fill(this->closed.begin(), this->closed.end(), 0);
+            this->search = 1;
+        }
+        this->open.clear();
+    }
+
+    uint32_t search;
+    std::vector<uint32_t> seen;
+    std::vector<uint32_t> closed;
+    std::vector<uint32_t> cost;
+    std::vector<uint32_t> parent;
+    std::vector<OpenNode> open;
+};
+
+uint32_t distance(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2)
+{
+    return (x1 > x2 ? x1 - x2 : x2 - x1) + (y1 > y2 ? y1 - y2 : y2 - y1);
+}
+} // namespace
+
+PathPlanner::PathPlanner(World* world, uint32_t maxExpansions, uint32_t hierarchicalDistance)
+        : world(world)
+        , maxExpansions(maxExpansions)
+        , hierarchicalDistance(hierarchicalDistance)
+        , topologyVersion(0)
+{
+}
+
+uint32_t PathPlanner::getMaxExpansions() const
+{
+    return this->maxExpansions;
+}
+
+void PathPlanner::update()
+{
+    std::lock_guard<std::recursive_mutex> guard(this->world->getDataMutex());
+    std::shared_ptr<const PassabilityGrid> current = this->getGrid();
+    if (!current || current->sizeX != this->world->getSizeX() || current->sizeY != this->world->getSizeY() ||
+            this->topologyVersion != this->world->getTopologyVersion()) {
+        this->rebuild();
+        return;
+    }
+
+    // queries still running keep the previous grid and graph alive
+    std::shared_ptr<world::RoomGraph> roomGraph;
+    bool changed = false;
+    for (DoorCell& doorCell : this->doors) {
+        bool open = doorCell.door->getState() == world::ObjectState::Open;
+        if (open == doorCell.open) {
+            continue;
+        }
+        doorCell.open = open;
+        changed = true;
+        if (current->roomGraph) {
+            if (!roomGraph) {
+                roomGraph = std::make_shared<world::RoomGraph>(*current->roomGraph);
+            }
+            roomGraph->setDoorOpen(doorCell.door->getID(), open);
+        }
+    }
+    if (changed) {
+        this->publish(roomGraph);
+    }
+}
+
+void PathPlanner::rebuild()
+{
+    uint32_t sizeY = this->world->getSizeY();
+    this->walls.assign(size_t(this->world->getSizeX()) * sizeY, 0);
+    this->doors.clear();
+    this->topologyVersion = this->world->getTopologyVersion();
+    for (auto& cellEntry : this->world->getGrid()) {
+        const world::Coordinate& coordinate = cellEntry.first;
+        if (coordinate.x < 0 || coordinate.y < 0 || uint32_t(coordinate.x) >= this->world->getSizeX() || uint32_t(coordinate.y) >= sizeY) {
+            continue;
+        }
+        uint32_t index = uint32_t(coordinate.x) * sizeY + coordinate.y;
+        if (cellEntry.second->getType() == world::RoomType::Wall) {
+            continue;
+        }
+        this->walls[index] = 1;
+        for (auto& objectEntry : cellEntry.second->getObjects()) {
+            if (objectEntry.second->getType() == world::ObjectType::Door) {
+                this->doors.push_back({objectEntry.second, index, objectEntry.second->getState() == world::ObjectState::Open});
+            }
+        }
+    }
+
+    std::shared_ptr<world::RoomGraph> roomGraph;
+    if (this->hierarchicalDistance > 0) {
+        roomGraph = std::make_shared<world::RoomGraph>();
+        roomGraph->build(this->world->getGrid(), this->world->getSizeX(), sizeY);
+    }
+    this->publish(roomGraph);
+}
+
+/**
+ * Publishes the passability of the walls and the current door states, with the given room graph or, if it is
+ * nullptr, the room graph published last.
+ */
+void PathPlanner::publish(const std::shared_ptr<const world::RoomGraph>& roomGraph)
+{
+    std::shared_ptr<PassabilityGrid> grid = std::make_shared<PassabilityGrid>();
+    grid->sizeX = this->world->getSizeX();
+    grid->sizeY = this->world->getSizeY();
+    grid->passable = this->walls;
+    for (const DoorCell& doorCell : this->doors) {
+        if (!doorCell.open) {
+            grid->passable[doorCell.index] = 0;
+        }
+    }
+    std::lock_guard<std::mutex> gridGuard(this->gridMutex);
+    grid->roomGraph = roomGraph ? roomGraph : (this->grid ? this->grid->roomGraph : nullptr);
+    this->grid = grid;
+}
+
+std::shared_ptr<const PathPlanner::PassabilityGrid> PathPlanner::getGrid() const
+{
+    std::lock_guard<std::mutex> guard(this->gridMutex);
+    return this->grid;
+}
+
+containers::PathResult PathPlanner::findPath(const containers::PathQuery& query) const
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    containers::PathResult result;
+    result.requestID = query.requestID;
+    result.receiverID = query.senderID;
+    result.expansions = 0;
+
+    std::shared_ptr<const PassabilityGrid> grid = this->getGrid();
+    if (!grid || query.fromX >= grid->sizeX || query.fromY >= grid->sizeY || query.toX >= grid->sizeX || query.toY >= grid->sizeY ||
+            !grid->passable[size_t(query.fromX) * grid->sizeY + query.fromY] || !grid->passable[size_t(query.toX) * grid->sizeY + query.toY]) {
+        result.status = containers::PathResult::Status::Invalid;
+    } else {
+        uint32_t limit = query.maxExpansions == 0 ? this->maxExpansions : std::min(query.maxExpansions, this->maxExpansions);
+        if (grid->roomGraph && distance(query.fromX, query.fromY, query.toX, query.toY) >= this->hierarchicalDistance) {
+            result.status = this->searchHierarchical(*grid, query, limit, result.path, result.expansions);
+        } else {
+            result.status = this->search(*grid, query.fromX, query.fromY, query.toX, query.toY, limit, result.path, result.expansions);
+        }
+    }
+
+    result.latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    result.timestamp = std::chrono::system_clock::now().time_since_epoch();
+    return result;
+}
+
+/**
+ * Follows the route over the room graph, each segment is a short search between two doors. If there is no route,
+ * e.g. because a room is split into parts, or a segment finds no path, the whole grid is searched, so the answer is
+ * the same as without the room graph. Only cells count against the limit, the expanded portals are bounded by the
+ * size of the graph.
+ */
+containers::PathResult::Status PathPlanner::searchHierarchical(const PassabilityGrid& grid, const containers::PathQuery& query, uint32_t limit,
+        std::vector<std::pair<uint32_t, uint32_t>>& path, uint32_t& expansions) const
+{
+    std::vector<world::Coordinate> waypoints;
+    uint32_t cost;
+    uint32_t portalExpansions;
+    if (!grid.roomGraph->findRoute(world::Coordinate(query.fromX, query.fromY), world::Coordinate(query.toX, query.toY), waypoints, cost, portalExpansions)) {
+        return this->search(grid, query.fromX, query.fromY, query.toX, query.toY, limit, path, expansions);
+    }
+    path.reserve(cost + 1);
+    for (size_t i = 1; i < waypoints.size(); i++) {
+        containers::PathResult::Status status = this->search(grid, waypoints[i - 1].x, waypoints[i - 1].y, waypoints[i].x, waypoints[i].y,
+                limit - std::min(expansions, limit), path, expansions);
+        if (status == containers::PathResult::Status::Found) {
+            continue;
+        }
+        if (status == containers::PathResult::Status::ExpansionLimit) {
+            return status;
+        }
+        path.clear();
+        return this->search(grid, query.fromX, query.fromY, query.toX, query.toY, limit - std::min(expansions, limit), path, expansions);
+    }
+    return containers::PathResult::Status::Found;
+}
+
+containers::PathResult::Status PathPlanner::search(const PassabilityGrid& grid, uint32_t fromX, uint32_t fromY, uint32_t toX, uint32_t toY,
+        uint32_t limit, std::vector<std::pair<uint32_t, uint32_t>>& path, uint32_t& expansions) const
+{
+    static thread_local SearchSpace space;
+    space.begin(grid.passable.size());
+    uint32_t sizeY = grid.sizeY;
+    uint32_t startIndex = fromX * sizeY + fromY;
+    uint32_t goalIndex = toX * sizeY + toY;
+    uint32_t searchExpansions = 0;
+
+    space.seen[startIndex] = space.search;
+    space.cost[startIndex] = 0;
+    space.parent[startIndex] = startIndex;
+    uint32_t h = distance(fromX, fromY, toX, toY);
+    space.open.push_back({h, h, startIndex});
+    while (!space.open.empty()) {
+        std::pop_heap(space.open.begin(), space.open.end());
+        uint32_t index = space.open.back().index;
+        space.open.pop_back();
+        if (space.closed[index] == space.search) {
+            continue;
+        }
+        space.closed[index] = space.search;
+        if (index == goalIndex) {
+            // continued paths already end with the start of this one
+            size_t first = path.size();
+            for (uint32_t i = goalIndex; i != startIndex; i = space.parent[i]) {
+                path.emplace_back(i / sizeY, i % sizeY);
+            }
+            if (first == 0) {
+                path.emplace_back(fromX, fromY);
+            }
+            std::reverse(path.begin() + first, path.end());
+            expansions += searchExpansions;
+            return containers::PathResult::Status::Found;
+        }
+        if (searchExpansions == limit) {
+            expansions += searchExpansions;
+            return containers::PathResult::Status::ExpansionLimit;
+        }
+        searchExpansions++;
+
+        uint32_t x = index / sizeY;
+        uint32_t y = index % sizeY;
+        uint32_t neighbours[4];
+        int count = 0;
+        if (x > 0) {
+            neighbours[count++] = index - sizeY;
+        }
+        if (x + 1 < grid.sizeX) {
+            neighbours[count++] = index + sizeY;
+        }
+        if (y > 0) {
+            neighbours[count++] = index - 1;
+        }
+        if (y + 1 < sizeY) {
+            neighbours[count++] = index + 1;
+        }
+        uint32_t cost = space.cost[index] + 1;
+        for (int i = 0; i < count; i++) {
+            uint32_t neighbour = neighbours[i];
+            if (!grid.passable[neighbour] || space.closed[neighbour] == space.search ||
+                    (space.seen[neighbour] == space.search && space.cost[neighbour] <= cost)) {
+                continue;
+            }
+            space.seen[neighbour] = space.search;
+            space.cost[neighbour] = cost;
+            space.parent[neighbour] = index;
+            h = distance(neighbour / sizeY, neighbour % sizeY, toX, toY);
+            space.open.push_back({cost + h, h, neighbour});
+            std::push_heap(space.open.begin(), space.open.end());
+        }
+    }
+    expansions += searchExpansions;
+    return containers::PathResult::Status::NoPath;
+}
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,108 @@
+#include "srg/sim/PerceptionApplier.h"
+
+#include "srg/sim/ContainerUtils.h"
+
+#include <srg/World.h>
+#include <srg/world/Cell.h>
+#include <srg/world/Object.h>
+
+#include <algorithm>
+
+namespace srg
+{
+namespace sim
+{
+PerceptionApplier::PerceptionApplier(srg::World& world, essentials::IDManager& idManager, IDHandleRegistry* handles)
+        : world(world)
+        , idManager(idManager)
+        , handles(handles)
+{
+}
+
+void PerceptionApplier::apply(::capnp::FlatArrayMessageReader& msg)
+{
+    this->apply(msg.getRoot<srg::sim::PerceptionMsg>());
+}
+
+void PerceptionApplier::apply(srg::sim::PerceptionMsg::Reader perceptionsReader)
+{
+    std::lock_guard<std::recursive_mutex> guard(this->world.getDataMutex());
+    for (srg::sim::PerceptionMsg::CellPerception::Reader cellReader : perceptionsReader.getCellPerceptions()) {
+        std::shared_ptr<srg::world::Cell> cell = this->world.editCell(srg::world::Coordinate(cellReader.getX(), cellReader.getY()));
+        if (!cell) {
+            continue;
+        }
+        cell->timeOfLastUpdate = cellReader.getTime();
+        this->applyObjects(cell, cellReader.getObjects(), 0);
+    }
+}
+
+void PerceptionApplier::apply(srg::sim::CompactPerceptionMsg::Reader perceptionsReader)
+{
+    std::lock_guard<std::recursive_mutex> guard(this->world.getDataMutex());
+    int64_t time = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::nanoseconds(perceptionsReader.getTimestamp())).count();
+    uint32_t width = perceptionsReader.getWidth();
+    uint32_t cellCount = width * perceptionsReader.getHeight();
+    ::capnp::Data::Reader visibility = perceptionsReader.getVisibility();
+    ::capnp::List<::srg::sim::CompactPerceptionMsg::ObjectCell>::Reader objectCells = perceptionsReader.getObjectCells();
+    unsigned int objectCellIdx = 0;
+    for (uint32_t index = 0; index < cellCount && index / 8 < visibility.size(); index++) {
+        if (!(visibility[index / 8] & (1 << (index % 8)))) {
+            continue;
+        }
+        std::shared_ptr<srg::world::Cell> cell =
+                this->world.editCell(srg::world::Coordinate(perceptionsReader.getOriginX() + index % width, perceptionsReader.getOriginY() + index / width));
+        while (objectCellIdx < objectCells.size() && objectCells[objectCellIdx].getIndex() < index) {
+            objectCellIdx++;
+        }
+        if (!cell) {
+            continue;
+        }
+        cell->timeOfLastUpdate = time;
+        if (objectCellIdx < objectCells.size() && objectCells[objectCellIdx].getIndex() == index) {
+            this->applyObjects(cell, objectCells[objectCellIdx].getObjects(), 0);
+        } else {
+            // visible, but empty
+            this->applyObjects(cell, ::capnp::List<srg::sim::PerceptionMsg::Object>::Reader(), 0);
+        }
+    }
+}
+
+/**
+ * Same semantics as ObjectSet::update: perceived objects are added or updated recursively, unseen objects are removed.
+ */
+void PerceptionApplier::applyObjects(
+        const std::shared_ptr<srg::world::ObjectSet>& objectSet, ::capnp::List<srg::sim::PerceptionMsg::Object>::Reader objectsReader, size_t depth)
+{
+    if (this->seenIDs.size() <= depth) {
+        this->seenIDs.resize(depth + 1);
+    }
+    // indexed access, because the recursion may resize the outer vector
+    this->seenIDs[depth].clear();
+    for (srg::sim::PerceptionMsg::Object::Reader objectReader : objectsReader) {
+        essentials::IdentifierConstPtr id = ContainerUtils::createID(objectReader.getId(), objectReader.getHandle(), this->idManager, this->handles);
+        if (!id) {
+            continue;
+        }
+        this->seenIDs[depth].push_back(id);
+        std::shared_ptr<srg::world::Object> object = this->world.createOrUpdateObject(
+                id, ContainerUtils::toObjectType(objectReader.getType()), ContainerUtils::toObjectState(objectReader.getState()));
+        if (!objectSet->contains(id)) {
+            objectSet->addObject(object);
+        }
+        this->applyObjects(object, objectReader.getObjects(), depth + 1);
+    }
+
+    this->unseenObjects.clear();
+    const std::vector<essentials::IdentifierConstPtr>& seen = this->seenIDs[depth];
+    for (auto& objectEntry : objectSet->getObjects()) {
+        if (std::find(seen.begin(), seen.end(), objectEntry.first) == seen.end()) {
+            this->unseenObjects.push_back(objectEntry.second);
+        }
+    }
+    for (std::shared_ptr<srg::world::Object>& object : this->unseenObjects) {
+        objectSet->removeObject(object);
+    }
+}
+} // namespace sim
+} // namespace srg
@@ -1,6 +1,5 @@
 #include "srg/sim/Sensor.h"
 
-#include "srg/Simulator.h"
 #include "srg/sim/SimulatedAgent.h"
 #include "srg/sim/containers/CellPerception.h"
 
@@ -12,6 +11,7 @@
 #include <essentials/SystemConfig.h>
 #include <cnc_geometry/Calculator.h>
 
+#include <algorithm>
 #include <chrono>
 
 namespace srg
@@ -25,47 +25,59 @@ Sensor::Sensor(srg::sim::SimulatedAgent* robot)
     this->sightLimit = sc["ObjectDetection"]->get<uint32_t>("sightLimit", NULL);
 }
 
-std::vector<containers::CellPerception> Sensor::createPerceptions(srg::Simulator* simulator)
+Sensor::Sensor(srg::sim::SimulatedAgent* robot, uint32_t sightLimit)
+        : robot(robot)
+        , sc(essentials::SystemConfig::getInstance())
+        , sightLimit(sightLimit)
 {
-    // collect cells in vision
-    world::Coordinate from = this->robot->getCoordinate();
-    std::map<world::Coordinate, std::shared_ptr<const world::Cell>> cellsInVision;
-    double increment = atan2(1, sightLimit + 1);
-    for (double currentDegree = -M_PI; currentDegree < M_PI; currentDegree += increment) { // PI/90 <=> 2 degree resolution
-        int32_t xDelta = round(sin(currentDegree) * sightLimit);
-        int32_t yDelta = round(cos(currentDegree) * sightLimit);
-        world::Coordinate to = world::Coordinate(from.x + xDelta, from.y + yDelta);
+}
 
-        std::vector<std::shared_ptr<const world::Cell>> currentCells = this->collectCells(from, to, simulator->getWorld());
-        for (std::shared_ptr<const world::Cell> cell : currentCells) {
-            // add only cells that are not already collected
-            if (cellsInVision.find(cell->coordinate) == cellsInVision.end()) {
-                cellsInVision.emplace(cell->coordinate, cell);
-            }
-        }
-    }
+std::vector<containers::CellPerception> Sensor::createPerceptions(srg::World* world)
+{
+    const std::vector<const world::Cell*>& cellsInVision = this->collectVisibleCells(world);
 
     // collect objects as perceptions
+    int64_t time = std::chrono::high_resolution_clock::now().time_since_epoch().count();
     std::vector<containers::CellPerception> cellPerceptionsList;
-    for (auto& entry : cellsInVision) {
-        auto& objects = entry.second->getObjects();
+    cellPerceptionsList.reserve(cellsInVision.size());
+    for (const world::Cell* cell : cellsInVision) {
+        auto& objects = cell->getObjects();
         containers::CellPerception cellPerceptions;
-        cellPerceptions.x = entry.second->coordinate.x;
-        cellPerceptions.y = entry.second->coordinate.y;
+        cellPerceptions.x = cell->coordinate.x;
+        cellPerceptions.y = cell->coordinate.y;
         for (auto& objectEntry : objects) {
             cellPerceptions.objects.push_back(objectEntry.second);
         }
-        cellPerceptions.time = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        cellPerceptions.time = time;
         cellPerceptionsList.push_back(cellPerceptions);
     }
 
     return cellPerceptionsList;
 }
 
-std::vector<std::shared_ptr<const world::Cell>> Sensor::collectCells(world::Coordinate start, world::Coordinate end, srg::World* world)
+const std::vector<const world::Cell*>& Sensor::collectVisibleCells(srg::World* world)
+{
+    // collect cells in vision
+    this->visibleCells.clear();
+    world::Coordinate from = this->robot->getCoordinate();
+    double increment = atan2(1, sightLimit + 1);
+    for (double currentDegree = -M_PI; currentDegree < M_PI; currentDegree += increment) { // PI/90 <=> 2 degree resolution
+        int32_t xDelta = round(sin(currentDegree) * sightLimit);
+        int32_t yDelta = round(cos(currentDegree) * sightLimit);
+        world::Coordinate to = world::Coordinate(from.x + xDelta, from.y + yDelta);
+        this->collectCells(from, to, world, this->visibleCells);
+    }
+
+    // add only cells that are not already collected
+    std::sort(this->visibleCells.begin(), this->visibleCells.end(),
+            [](const world::Cell* first, const world::Cell* second) { return first->coordinate < second->coordinate; });
+    this->visibleCells.erase(std::unique(this->visibleCells.begin(), this->visibleCells.end()), this->visibleCells.end());
+    return this->visibleCells;
+}
+
+void Sensor::collectCells(world::Coordinate start, world::Coordinate end, srg::World* world, std::vector<const world::Cell*>& cells)
 {
-    std::vector<std::shared_ptr<const world::Cell>> cells;
-    cells.push_back(world->getCell(start));
+    cells.push_back(world->getCell(start).get());
 
     int32_t sign_x = ((int32_t) end.x - (int32_t) start.x) > 0 ? 1 : -1;
     int32_t sign_y = ((int32_t) end.y - (int32_t) start.y) > 0 ? 1 : -1;
@@ -99,9 +111,8 @@ std::vector<std::shared_ptr<const world::Cell>> Sensor::collectCells(world::Coor
         if (sightBlocked) {
             break;
         }
-        cells.push_back(cell);
+        cells.push_back(cell.get());
     }
-    return cells;
 }
 } // namespace sim
 } // namespace srg
\ No newline at end of file
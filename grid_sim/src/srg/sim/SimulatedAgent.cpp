@@ -14,6 +14,13 @@ SimulatedAgent::SimulatedAgent(std::shared_ptr<world::Agent> agent)
     this->objectDetection = new Sensor(this);
 }
 
+SimulatedAgent::SimulatedAgent(std::shared_ptr<world::Agent> agent, uint32_t sightLimit)
+        : agent(agent)
+{
+    this->manipulation = new Arm(this);
+    this->objectDetection = new Sensor(this, sightLimit);
+}
+
 world::Coordinate SimulatedAgent::getCoordinate()
 {
     return std::dynamic_pointer_cast<const world::Cell>(this->agent->getParentContainer())->coordinate;
@@ -38,19 +45,23 @@ essentials::IdentifierConstPtr SimulatedAgent::getID()
     return this->agent->getID();
 }
 
-containers::Perceptions SimulatedAgent::createSimPerceptions(Simulator* simulator)
+containers::Perceptions SimulatedAgent::createSimPerceptions(World* world)
 {
     containers::Perceptions sps;
     sps.receiverID = this->getID();
     sps.timestamp = std::chrono::system_clock::now().time_since_epoch();
 
     // objects
-    std::vector<containers::CellPerception> objectPerceptions = this->objectDetection->createPerceptions(simulator);
-    sps.cellPerceptions.insert(sps.cellPerceptions.end(), objectPerceptions.begin(), objectPerceptions.end());
+    sps.cellPerceptions = this->objectDetection->createPerceptions(world);
 
     return sps;
 }
 
+const std::vector<const world::Cell*>& SimulatedAgent::collectVisibleCells(World* world)
+{
+    return this->objectDetection->collectVisibleCells(world);
+}
+
 void SimulatedAgent::executeAction(containers::SimCommand sc, World* world)
 {
     this->manipulation->execute(sc, world);
@@ -0,0 +1,97 @@
+#include "srg/sim/WorldDeltaDecoder.h"
+
+#include "srg/sim/ContainerUtils.h"
+
+#include <essentials/IDManager.h>
+
+#include <algorithm>
+
+namespace srg
+{
+namespace sim
+{
+WorldDeltaDecoder::WorldDeltaDecoder(essentials::IDManager& idManager, IDHandleRegistry* handles)
+        : idManager(idManager)
+        , handles(handles)
+        , synchronised(false)
+        , tick(0)
+{
+}
+
+bool WorldDeltaDecoder::isSynchronised() const
+{
+    return this->synchronised;
+}
+
+uint64_t WorldDeltaDecoder::getTick() const
+{
+    return this->tick;
+}
+
+bool WorldDeltaDecoder::applyDelta(srg::sim::WorldDeltaMsg::Reader deltaReader)
+{
+    if (deltaReader.getKeyframe()) {
+        this->cells.clear();
+        this->synchronised = true;
+    } else if (!this->synchronised || deltaReader.getTick() != this->tick + 1) {
+        this->synchronised = false;
+        return false;
+    }
+    this->tick = deltaReader.getTick();
+
+    for (srg::sim::WorldDeltaMsg::CellUpdate::Reader cellReader : deltaReader.getCells()) {
+        srg::world::Coordinate coordinate(cellReader.getX(), cellReader.getY());
+        if (cellReader.getObjects().size() == 0) {
+            this->cells.erase(coordinate);
+            continue;
+        }
+        std::vector<std::shared_ptr<srg::world::Object>>& objects = this->cells[coordinate];
+        objects.clear();
+        for (srg::sim::PerceptionMsg::Object::Reader objectReader : cellReader.getObjects()) {
+            if (std::shared_ptr<srg::world::Object> object = ContainerUtils::createObject(objectReader, this->idManager, this->handles)) {
+                objects.push_back(object);
+            }
+        }
+    }
+    return true;
+}
+
+bool WorldDeltaDecoder::createPerceptions(srg::sim::VisibilityMsg::Reader visibilityReader, containers::Perceptions& perceptions) const
+{
+    if (!this->synchronised || visibilityReader.getTick() != this->tick) {
+        return false;
+    }
+
+    perceptions.receiverID = this->idManager.getIDFromBytes(visibilityReader.getReceiverID().getValue().asBytes().begin(),
+            visibilityReader.getReceiverID().getValue().size(), visibilityReader.getReceiverID().getType());
+    perceptions.timestamp = std::chrono::nanoseconds(visibilityReader.getTimestamp());
+    int64_t time = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(perceptions.timestamp).count();
+    perceptions.cellPerceptions.clear();
+
+    uint32_t width = visibilityReader.getWidth();
+    uint32_t cellCount = width * visibilityReader.getHeight();
+    ::capnp::Data::Reader visibility = visibilityReader.getVisibility();
+    for (uint32_t index = 0; index < cellCount && index / 8 < visibility.size(); index++) {
+        if (!(visibility[index / 8] & (1 << (index % 8)))) {
+            continue;
+        }
+        srg::sim::containers::CellPerception cellPerception;
+        cellPerception.x = visibilityReader.getOriginX() + index % width;
+        cellPerception.y = visibilityReader.getOriginY() + index / width;
+        cellPerception.time = time;
+        auto cellEntry = this->cells.find(srg::world::Coordinate(cellPerception.x, cellPerception.y));
+        if (cellEntry != this->cells.end()) {
+            cellPerception.objects = cellEntry->second;
+        }
+        perceptions.cellPerceptions.push_back(cellPerception);
+    }
+
+    // same order as the version 1 message
+    std::sort(perceptions.cellPerceptions.begin(), perceptions.cellPerceptions.end(),
+            [](const containers::CellPerception& first, const containers::CellPerception& second) {
+                return first.x < second.x || (first.x == second.x && first.y < second.y);
+            });
+    return true;
+}
+} // namespace sim
+} // namespace srg
@@ -2,11 +2,21 @@
 
 #include "srg/Simulator.h"
 #include "srg/sim/ContainerUtils.h"
+#include "srg/sim/IDHandleRegistry.h"
+#include "srg/sim/SimulatedAgent.h"
+#include "srg/sim/communication/LoopbackTransport.h"
+#include "srg/sim/communication/ShmTransport.h"
+#include "srg/sim/communication/UDPTransport.h"
+#include "srg/sim/profiling/TickProfiler.h"
+
+#include <srg/World.h>
+#include <srg/world/Cell.h>
 
 #include <essentials/SystemConfig.h>
-#include <capnzero/Subscriber.h>
 #include <essentials/IDManager.h>
 
+#include <algorithm>
+#include <functional>
 #include <vector>
 
 namespace srg
@@ -16,49 +26,352 @@ namespace sim
 namespace communication
 {
 
-Communication::Communication(essentials::IDManager* idManager, Simulator* simulator)
+Communication::Communication(essentials::IDManager* idManager, Simulator* simulator, Transport* transport)
         : simulator(simulator)
         , idManager(idManager)
         , sc(essentials::SystemConfig::getInstance())
+        , transport(transport)
+        , ownsTransport(transport == nullptr)
 {
-    this->ctx = zmq_ctx_new();
-    this->address = sc["SRGSim"]->get<std::string>("SRGSim.Communication.address", NULL);
+    if (!this->transport) {
+        this->transport = this->createTransport();
+    }
+    this->simPerceptionsTopic = sc["SRGSim"]->get<std::string>("SRGSim.Communication.perceptionsTopic", NULL);
+    this->readPerceptionFormat();
+    this->readPerceptionMode();
+    // ID handles are needed for decoding commands, so subscribe afterwards
+    this->readIDHandles();
+
     this->simCommandTopic = sc["SRGSim"]->get<std::string>("SRGSim.Communication.cmdTopic", NULL);
+    this->transport->subscribe(this->simCommandTopic, std::bind(&Communication::onSimCommand, this, std::placeholders::_1));
 
-    this->simCommandSub = new capnzero::Subscriber(this->ctx, capnzero::Protocol::UDP);
-    this->simCommandSub->setTopic(this->simCommandTopic);
-    this->simCommandSub->addAddress(this->address);
-    this->simCommandSub->setReceiveQueueSize(1000);
-    this->simCommandSub->subscribe(&Communication::onSimCommand, &(*this));
+    this->simCommandBatchTopic = sc["SRGSim"]->tryGet<std::string>(this->simCommandTopic + "Batch", "SRGSim.Communication.cmdBatchTopic", NULL);
+    this->transport->subscribe(this->simCommandBatchTopic, std::bind(&Communication::onSimCommandBatch, this, std::placeholders::_1));
 
-    this->simPerceptionsTopic = sc["SRGSim"]->get<std::string>("SRGSim.Communication.perceptionsTopic", NULL);
-    this->simPerceptionsPub = new capnzero::Publisher(this->ctx, capnzero::Protocol::UDP);
-    this->simPerceptionsPub->setDefaultTopic(simPerceptionsTopic);
-    this->simPerceptionsPub->addAddress(this->address);
-    this->simPerceptionsPub->setSendQueueSize(1000);
+    this->pathQueryTopic = sc["SRGSim"]->tryGet<std::string>(this->simCommandTopic + "PathQuery", "SRGSim.Communication.pathQueryTopic", NULL);
+    this->pathResponseTopic = sc["SRGSim"]->tryGet<std::string>(this->simPerceptionsTopic + "Path", "SRGSim.Communication.pathResponseTopic", NULL);
+    this->transport->subscribe(this->pathQueryTopic, std::bind(&Communication::onPathQuery, this, std::placeholders::_1));
+}
+
+Transport* Communication::getTransport()
+{
+    return this->transport;
+}
+
+void Communication::readIDHandles()
+{
+    this->allHandlesRequested = false;
+    if (!sc["SRGSim"]->tryGet<bool>(false, "SRGSim.Communication.idHandles", NULL)) {
+        this->idHandles = nullptr;
+        return;
+    }
+    this->idHandles = new IDHandleRegistry();
+    this->idMappingTopic = sc["SRGSim"]->tryGet<std::string>(this->simPerceptionsTopic + "IDMapping", "SRGSim.Communication.idMappingTopic", NULL);
+    this->idMappingRequestTopic = sc["SRGSim"]->tryGet<std::string>(this->idMappingTopic + "Request", "SRGSim.Communication.idMappingRequestTopic", NULL);
+    this->transport->subscribe(this->idMappingRequestTopic, std::bind(&Communication::onIDMappingRequest, this, std::placeholders::_1));
+}
+
+Transport* Communication::createTransport()
+{
+    std::string transportName = sc["SRGSim"]->tryGet<std::string>("udp", "SRGSim.Communication.transport", NULL);
+    if (transportName.compare("shm") == 0) {
+        uint32_t slotCount = sc["SRGSim"]->tryGet<uint32_t>(64, "SRGSim.Communication.shmSlotCount", NULL);
+        uint32_t slotSize = sc["SRGSim"]->tryGet<uint32_t>(65536, "SRGSim.Communication.shmSlotSize", NULL);
+        int pollInterval = sc["SRGSim"]->tryGet<int>(500, "SRGSim.Communication.shmPollInterval", NULL);
+        return new ShmTransport(slotCount, slotSize, std::chrono::microseconds(pollInterval));
+    }
+    if (transportName.compare("loopback") == 0) {
+        return new LoopbackTransport();
+    }
+    if (transportName.compare("udp") != 0) {
+        std::cerr << "[Communication] Unknown transport '" << transportName << "', using udp!" << std::endl;
+    }
+    return new UDPTransport(sc["SRGSim"]->get<std::string>("SRGSim.Communication.address", NULL));
+}
+
+void Communication::readPerceptionFormat()
+{
+    std::string format = sc["SRGSim"]->tryGet<std::string>("v1", "SRGSim.Communication.perceptionFormat", NULL);
+    this->compactPerceptions = format.compare("v2") == 0;
+    if (!this->compactPerceptions && format.compare("v1") != 0) {
+        std::cerr << "[Communication] Unknown perception format '" << format << "', using v1!" << std::endl;
+    }
+
+    std::string framing = sc["SRGSim"]->tryGet<std::string>("none", "SRGSim.Communication.perceptionFraming", NULL);
+    if (framing.compare("packed") == 0) {
+        this->perceptionFraming = srg::sim::FramedMsg::Framing::PACKED;
+    } else if (framing.compare("lz4") == 0) {
+        this->perceptionFraming = srg::sim::FramedMsg::Framing::LZ4;
+    } else {
+        if (framing.compare("none") != 0) {
+            std::cerr << "[Communication] Unknown perception framing '" << framing << "', using none!" << std::endl;
+        }
+        this->perceptionFraming = srg::sim::FramedMsg::Framing::NONE;
+    }
+    if (!ContainerUtils::isFramingSupported(this->perceptionFraming)) {
+        std::cerr << "[Communication] Compiled without LZ4 support, using packed framing!" << std::endl;
+        this->perceptionFraming = srg::sim::FramedMsg::Framing::PACKED;
+    }
+    if (!this->compactPerceptions && this->perceptionFraming != srg::sim::FramedMsg::Framing::NONE) {
+        std::cerr << "[Communication] Framing is only supported for the v2 perception format!" << std::endl;
+        this->perceptionFraming = srg::sim::FramedMsg::Framing::NONE;
+    }
+}
+
+void Communication::readPerceptionMode()
+{
+    std::string mode = sc["SRGSim"]->tryGet<std::string>("perAgent", "SRGSim.Communication.perceptionMode", NULL);
+    this->broadcastPerceptions = mode.compare("broadcast") == 0;
+    if (!this->broadcastPerceptions && mode.compare("perAgent") != 0) {
+        std::cerr << "[Communication] Unknown perception mode '" << mode << "', using perAgent!" << std::endl;
+    }
+    this->worldDeltaTopic = sc["SRGSim"]->tryGet<std::string>(this->simPerceptionsTopic + "Delta", "SRGSim.Communication.worldDeltaTopic", NULL);
+    this->visibilityTopic = sc["SRGSim"]->tryGet<std::string>(this->simPerceptionsTopic + "Visibility", "SRGSim.Communication.visibilityTopic", NULL);
+    this->keyframeInterval = std::max(1, sc["SRGSim"]->tryGet<int>(33, "SRGSim.Communication.keyframeInterval", NULL));
+    this->deltaTick = 0;
 }
 
 Communication::~Communication()
 {
-    delete this->simCommandSub;
-    zmq_ctx_term(this->ctx);
+    if (this->ownsTransport) {
+        delete this->transport;
+    }
+    delete this->idHandles;
 }
 
 void Communication::onSimCommand(::capnp::FlatArrayMessageReader& msg)
 {
-    containers::SimCommand simCommand = ContainerUtils::toSimCommand(msg, *this->idManager);
-    std::chrono::duration<double, std::milli> sendTime = std::chrono::system_clock::now().time_since_epoch() - simCommand.timestamp;
+    containers::SimCommand simCommand = ContainerUtils::toSimCommand(msg, *this->idManager, this->idHandles);
+    if (!simCommand.senderID) {
+        // unknown sender handle, the registry remembers it for announceIDHandles
+        return;
+    }
+    simCommand.receiveTime = std::chrono::system_clock::now().time_since_epoch();
+    this->simulator->getProfiler()->getAgentTelemetry().recordReceived(simCommand);
+    std::chrono::duration<double, std::milli> sendTime = simCommand.receiveTime - simCommand.timestamp;
     if (sendTime > std::chrono::milliseconds (15)) {
         std::cerr << "[Communication] SimCommand took " << sendTime.count() << "ms" << std::endl;
     }
     this->simulator->processSimCommand(simCommand);
 }
 
-void Communication::sendSimPerceptions(srg::sim::containers::Perceptions sp)
+void Communication::onSimCommandBatch(::capnp::FlatArrayMessageReader& msg)
+{
+    this->simCommandBatch.clear();
+    ContainerUtils::toSimCommands(msg, *this->idManager, this->simCommandBatch, this->idHandles);
+    this->simCommandBatch.erase(std::remove_if(this->simCommandBatch.begin(), this->simCommandBatch.end(),
+                                        [](const containers::SimCommand& simCommand) { return !simCommand.senderID; }),
+            this->simCommandBatch.end());
+    if (this->simCommandBatch.empty()) {
+        return;
+    }
+    std::chrono::system_clock::duration receiveTime = std::chrono::system_clock::now().time_since_epoch();
+    for (containers::SimCommand& simCommand : this->simCommandBatch) {
+        simCommand.receiveTime = receiveTime;
+        this->simulator->getProfiler()->getAgentTelemetry().recordReceived(simCommand);
+    }
+    std::chrono::duration<double, std::milli> sendTime = receiveTime - this->simCommandBatch.front().timestamp;
+    if (sendTime > std::chrono::milliseconds(15)) {
+        std::cerr << "[Communication] SimCommandBatch took " << sendTime.count() << "ms" << std::endl;
+    }
+    this->simulator->processSimCommands(this->simCommandBatch);
+}
+
+void Communication::onIDMappingRequest(::capnp::FlatArrayMessageReader& msg)
+{
+    IDMappingRequestMsg::Reader request = msg.getRoot<IDMappingRequestMsg>();
+    // answered by the simulator thread, before the next perceptions are sent
+    std::lock_guard<std::mutex> guard(this->requestedHandlesMutex);
+    if (request.getHandles().size() == 0) {
+        this->allHandlesRequested = true;
+    }
+    for (uint32_t handle : request.getHandles()) {
+        this->requestedHandles.push_back(handle);
+    }
+}
+
+void Communication::onPathQuery(::capnp::FlatArrayMessageReader& msg)
 {
+    containers::PathQuery query = ContainerUtils::toPathQuery(msg, *this->idManager, this->idHandles);
+    if (!query.senderID) {
+        // unknown sender handle, nobody to respond to
+        return;
+    }
+    // searched on the receiving thread, only sending is left to the simulator thread
+    containers::PathResult result = this->simulator->findPath(query);
+    std::lock_guard<std::mutex> guard(this->pathResultsMutex);
+    this->pathResults.push_back(std::move(result));
+}
+
+void Communication::sendPathResponses()
+{
+    // also answers mapping requests in iterations without perceptions, e.g. before any agent spawned
+    this->announceIDHandles();
+    {
+        std::lock_guard<std::mutex> guard(this->pathResultsMutex);
+        this->sentPathResults.swap(this->pathResults);
+    }
+    for (const containers::PathResult& result : this->sentPathResults) {
+        ::capnp::MallocMessageBuilder msgBuilder;
+        PathResponseMsg::Builder msg = msgBuilder.initRoot<PathResponseMsg>();
+        ContainerUtils::toMsg(result, msg);
+        this->transport->send(this->pathResponseTopic, msgBuilder);
+    }
+    this->sentPathResults.clear();
+}
+
+void Communication::removeAgent(essentials::IdentifierConstPtr agentID)
+{
+    this->perceptionArenas.erase(agentID);
+    this->framingArenas.erase(agentID);
+}
+
+void Communication::announceIDHandles()
+{
+    if (!this->idHandles) {
+        return;
+    }
+    this->announcedHandles.clear();
+    this->idHandles->takeMissing(this->announcedHandles);
+    if (!this->announcedHandles.empty()) {
+        // messages were dropped because their handles are unknown here, e.g. after a restart of the simulator,
+        // so the senders learn the current mapping and fall back to full IDs for unmapped ones
+        std::cerr << "[Communication] Dropped messages with " << this->announcedHandles.size() << " unknown ID handles, announcing all handles!"
+                  << std::endl;
+        std::lock_guard<std::mutex> guard(this->requestedHandlesMutex);
+        this->allHandlesRequested = true;
+    }
+    this->announcedHandles.clear();
+    this->idHandles->takeUnannounced(this->announcedHandles);
+    {
+        std::lock_guard<std::mutex> guard(this->requestedHandlesMutex);
+        if (this->allHandlesRequested) {
+            this->announcedHandles.clear();
+            for (uint32_t handle = 1; handle <= this->idHandles->getHandleCount(); handle++) {
+                this->announcedHandles.push_back(handle);
+            }
+            this->allHandlesRequested = false;
+        } else {
+            this->announcedHandles.insert(this->announcedHandles.end(), this->requestedHandles.begin(), this->requestedHandles.end());
+        }
+        this->requestedHandles.clear();
+    }
+    if (this->announcedHandles.empty()) {
+        return;
+    }
+
     ::capnp::MallocMessageBuilder msgBuilder;
-    ContainerUtils::toMsg(sp, msgBuilder);
-    this->simPerceptionsPub->send(msgBuilder);
+    IDMappingMsg::Builder msg = msgBuilder.initRoot<IDMappingMsg>();
+    ContainerUtils::toMsg(this->announcedHandles, *this->idHandles, msg);
+    this->transport->send(this->idMappingTopic, msgBuilder);
+}
+
+void Communication::sendSimPerceptions(const srg::sim::containers::Perceptions& sp)
+{
+    profiling::TickProfiler* profiler = this->simulator->getProfiler();
+    // reuse the first segment of the last message for this agent
+    MessageArena& arena = this->perceptionArenas[sp.receiverID];
+    ::capnp::MallocMessageBuilder msgBuilder(arena.getFirstSegment());
+    {
+        profiling::ScopedTimer serializationTimer(profiler->getHistogram(profiling::Phase::Serialization));
+        ContainerUtils::toMsg(sp, msgBuilder);
+    }
+    this->sendPerception(this->simPerceptionsTopic, msgBuilder);
+    arena.recycle(msgBuilder);
+}
+
+void Communication::sendSimPerceptions(srg::sim::SimulatedAgent* agent, srg::World* world)
+{
+    profiling::TickProfiler* profiler = this->simulator->getProfiler();
+    const std::vector<const world::Cell*>* cells;
+    {
+        profiling::ScopedTimer perceptionTimer(profiler->getHistogram(profiling::Phase::Perception));
+        cells = &agent->collectVisibleCells(world);
+    }
+
+    MessageArena& arena = this->perceptionArenas[agent->getID()];
+    ::capnp::MallocMessageBuilder msgBuilder(arena.getFirstSegment());
+    if (this->broadcastPerceptions) {
+        {
+            profiling::ScopedTimer serializationTimer(profiler->getHistogram(profiling::Phase::Serialization));
+            VisibilityMsg::Builder msg = msgBuilder.initRoot<VisibilityMsg>();
+            ContainerUtils::toMsg(agent->getID(), this->deltaTick, std::chrono::system_clock::now().time_since_epoch(), *cells, msg);
+        }
+        this->sendPerception(this->visibilityTopic, msgBuilder);
+        arena.recycle(msgBuilder);
+        return;
+    }
+    {
+        profiling::ScopedTimer serializationTimer(profiler->getHistogram(profiling::Phase::Serialization));
+        if (this->compactPerceptions) {
+            CompactPerceptionMsg::Builder msg = msgBuilder.initRoot<CompactPerceptionMsg>();
+            ContainerUtils::toMsg(agent->getID(), std::chrono::system_clock::now().time_since_epoch(), *cells, msg, this->idHandles);
+        } else {
+            PerceptionMsg::Builder msg = msgBuilder.initRoot<PerceptionMsg>();
+            ContainerUtils::toMsg(agent->getID(), std::chrono::system_clock::now().time_since_epoch(), *cells, msg, this->idHandles);
+        }
+    }
+    // handles have to be known before the perceptions using them arrive
+    this->announceIDHandles();
+    this->send(msgBuilder, agent->getID());
+    arena.recycle(msgBuilder);
+}
+
+void Communication::sendWorldDelta(srg::World* world)
+{
+    if (!this->broadcastPerceptions) {
+        return;
+    }
+    profiling::TickProfiler* profiler = this->simulator->getProfiler();
+    this->deltaTick++;
+    ::capnp::MallocMessageBuilder msgBuilder(this->deltaArena.getFirstSegment());
+    {
+        profiling::ScopedTimer serializationTimer(profiler->getHistogram(profiling::Phase::Serialization));
+        std::lock_guard<std::recursive_mutex> guard(world->getDataMutex());
+        // always take the changes, so the next delta starts after this one
+        world->takeChangedCells(this->deltaCells);
+        bool keyframe = (this->deltaTick - 1) % this->keyframeInterval == 0;
+        if (keyframe) {
+            this->deltaCells.clear();
+            for (auto& cellEntry : world->getGrid()) {
+                if (!cellEntry.second->getObjects().empty()) {
+                    this->deltaCells.push_back(cellEntry.second.get());
+                }
+            }
+        }
+        WorldDeltaMsg::Builder msg = msgBuilder.initRoot<WorldDeltaMsg>();
+        ContainerUtils::toMsg(this->deltaTick, std::chrono::system_clock::now().time_since_epoch(), keyframe, this->deltaCells, msg, this->idHandles);
+    }
+    this->announceIDHandles();
+    this->sendPerception(this->worldDeltaTopic, msgBuilder);
+    this->deltaArena.recycle(msgBuilder);
+}
+
+void Communication::send(::capnp::MallocMessageBuilder& msgBuilder, essentials::IdentifierConstPtr receiverID)
+{
+    profiling::TickProfiler* profiler = this->simulator->getProfiler();
+    if (this->perceptionFraming == srg::sim::FramedMsg::Framing::NONE) {
+        this->sendPerception(this->simPerceptionsTopic, msgBuilder);
+        return;
+    }
+
+    MessageArena& arena = this->framingArenas[receiverID];
+    ::capnp::MallocMessageBuilder framedBuilder(arena.getFirstSegment());
+    {
+        profiling::ScopedTimer serializationTimer(profiler->getHistogram(profiling::Phase::Serialization));
+        FramedMsg::Builder framedMsg = framedBuilder.initRoot<FramedMsg>();
+        ContainerUtils::frame(this->perceptionFraming, msgBuilder, this->framingBuffer, framedMsg);
+    }
+    this->sendPerception(this->simPerceptionsTopic, framedBuilder);
+    arena.recycle(framedBuilder);
+}
+
+void Communication::sendPerception(const std::string& topic, ::capnp::MallocMessageBuilder& msgBuilder)
+{
+    profiling::TickProfiler* profiler = this->simulator->getProfiler();
+    profiler->countPerception(::capnp::computeSerializedSizeInWords(msgBuilder) * sizeof(::capnp::word));
+    profiling::ScopedTimer sendTimer(profiler->getHistogram(profiling::Phase::Send));
+    this->transport->send(topic, msgBuilder);
 }
 } // namespace communication
 } // namespace sim
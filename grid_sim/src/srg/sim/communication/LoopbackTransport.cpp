@@ -0,0 +1,75 @@
+#include "srg/sim/communication/LoopbackTransport.h"
+
+#include <kj/io.h>
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+LoopbackTransport::LoopbackTransport(bool queued)
+        : queued(queued)
+        , delivering(false)
+{
+}
+
+void LoopbackTransport::subscribe(const std::string& topic, Callback callback)
+{
+    std::lock_guard<std::recursive_mutex> guard(this->subscriptionMutex);
+    this->subscriptions.emplace(topic, callback);
+}
+
+void LoopbackTransport::send(const std::string& topic, ::capnp::MallocMessageBuilder& msgBuilder)
+{
+    if (this->queued) {
+        std::lock_guard<std::mutex> guard(this->queueMutex);
+        this->queue.emplace_back(topic, ::capnp::messageToFlatArray(msgBuilder));
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> guard(this->subscriptionMutex);
+    if (this->delivering) {
+        // sent from within a callback, the buffer is still read
+        kj::Array<::capnp::word> words = ::capnp::messageToFlatArray(msgBuilder);
+        this->deliver(topic, words.asPtr());
+        return;
+    }
+    // the buffer is reused, because subscribers only read the message during the callback
+    this->buffer.resize(::capnp::computeSerializedSizeInWords(msgBuilder));
+    kj::ArrayOutputStream output(kj::arrayPtr(reinterpret_cast<kj::byte*>(this->buffer.data()), this->buffer.size() * sizeof(::capnp::word)));
+    ::capnp::writeMessage(output, msgBuilder);
+    this->deliver(topic, kj::arrayPtr(this->buffer.data(), this->buffer.size()));
+}
+
+size_t LoopbackTransport::poll()
+{
+    std::deque<std::pair<std::string, kj::Array<::capnp::word>>> messages;
+    {
+        std::lock_guard<std::mutex> guard(this->queueMutex);
+        messages.swap(this->queue);
+    }
+    std::lock_guard<std::recursive_mutex> guard(this->subscriptionMutex);
+    for (auto& message : messages) {
+        this->deliver(message.first, message.second.asPtr());
+    }
+    return messages.size();
+}
+
+/**
+ * Has to be called with the subscriptionMutex locked.
+ */
+void LoopbackTransport::deliver(const std::string& topic, kj::ArrayPtr<const ::capnp::word> words)
+{
+    bool wasDelivering = this->delivering;
+    this->delivering = true;
+    auto range = this->subscriptions.equal_range(topic);
+    for (auto it = range.first; it != range.second; it++) {
+        ::capnp::FlatArrayMessageReader msgReader(words);
+        it->second(msgReader);
+    }
+    this->delivering = wasDelivering;
+}
+} // namespace communication
+} // namespace sim
+} // namespace srg
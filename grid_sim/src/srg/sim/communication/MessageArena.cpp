@@ -0,0 +1,53 @@
+#include "srg/sim/communication/MessageArena.h"
+
+#include <cstring>
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+MessageArena::MessageArena(size_t initialSizeInWords)
+        : requiredSizeInWords(initialSizeInWords)
+{
+    this->allocate(initialSizeInWords);
+}
+
+kj::ArrayPtr<::capnp::word> MessageArena::getFirstSegment()
+{
+    if (this->requiredSizeInWords > this->firstSegment.size()) {
+        // the last message overflowed, so grow the first segment to fit it next time
+        this->allocate(this->requiredSizeInWords + this->requiredSizeInWords / 4);
+    }
+    return this->firstSegment.asPtr();
+}
+
+void MessageArena::recycle(::capnp::MallocMessageBuilder& builder)
+{
+    kj::ArrayPtr<const kj::ArrayPtr<const ::capnp::word>> segments = builder.getSegmentsForOutput();
+    if (segments.size() == 1 && segments[0].begin() == this->firstSegment.begin()) {
+        return;
+    }
+
+    size_t sizeInWords = 0;
+    for (auto& segment : segments) {
+        sizeInWords += segment.size();
+    }
+    this->requiredSizeInWords = sizeInWords;
+}
+
+size_t MessageArena::getSizeInWords() const
+{
+    return this->firstSegment.size();
+}
+
+void MessageArena::allocate(size_t sizeInWords)
+{
+    // capnp requires the first segment to be zeroed
+    this->firstSegment = kj::heapArray<::capnp::word>(sizeInWords);
+    memset(this->firstSegment.begin(), 0, sizeInWords * sizeof(::capnp::word));
+}
+} // namespace communication
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,226 @@
+#include "srg/sim/communication/ShmRing.h"
+
+#include <kj/exception.h>
+#include <kj/io.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+const uint32_t ShmRing::MAGIC;
+const uint32_t ShmRing::VERSION;
+const int ShmRing::ATTACH_ATTEMPTS;
+
+ShmRing::ShmRing(const std::string& topic, bool create, uint32_t slotCount, uint32_t slotSize)
+        : name(toSegmentName(topic))
+        , fd(-1)
+        , segmentSize(0)
+        , header(nullptr)
+        , cursor(0)
+        , lostMessages(0)
+        , created(false)
+{
+    // slots are word aligned, so messages are copied out of them in whole words
+    slotSize = (slotSize + sizeof(::capnp::word) - 1) / sizeof(::capnp::word) * sizeof(::capnp::word);
+
+    // only the process that creates the segment initialises it, everybody else attaches to it
+    if (create) {
+        this->fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+        this->created = this->fd >= 0;
+    }
+    if (this->fd < 0) {
+        this->fd = shm_open(this->name.c_str(), O_RDWR, 0666);
+    }
+    if (this->fd < 0) {
+        std::cerr << "[ShmRing] Unable to open shared memory segment '" << this->name << "'!" << std::endl;
+        return;
+    }
+
+    if (this->created) {
+        this->segmentSize = sizeof(Header) + size_t(slotCount) * (sizeof(SlotHeader) + slotSize);
+        if (ftruncate(this->fd, this->segmentSize) != 0) {
+            std::cerr << "[ShmRing] Unable to resize shared memory segment '" << this->name << "'!" << std::endl;
+            return;
+        }
+    } else {
+        // the creator might still be resizing the segment
+        struct stat segmentStat;
+        for (int attempt = 0; fstat(this->fd, &segmentStat) == 0 && size_t(segmentStat.st_size) < sizeof(Header) && attempt < ATTACH_ATTEMPTS;
+                attempt++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (fstat(this->fd, &segmentStat) != 0 || size_t(segmentStat.st_size) < sizeof(Header)) {
+            std::cerr << "[ShmRing] Shared memory segment '" << this->name << "' is not initialised!" << std::endl;
+            return;
+        }
+        this->segmentSize = segmentStat.st_size;
+    }
+
+    void* segment = mmap(nullptr, this->segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (segment == MAP_FAILED) {
+        std::cerr << "[ShmRing] Unable to map shared memory segment '" << this->name << "'!" << std::endl;
+        return;
+    }
+    this->header = static_cast<Header*>(segment);
+
+    if (this->created) {
+        this->header->slotCount = slotCount;
+        this->header->slotSize = slotSize;
+        this->header->head.store(0);
+        for (uint32_t i = 0; i < slotCount; i++) {
+            this->getSlot(i)->sequence.store(0);
+        }
+        this->header->version = VERSION;
+        std::atomic_thread_fence(std::memory_order_release);
+        this->header->magic = MAGIC;
+    } else {
+        // ... or still initialising the header
+        for (int attempt = 0; this->header->magic != MAGIC && attempt < ATTACH_ATTEMPTS; attempt++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (this->header->magic != MAGIC || this->header->version != VERSION ||
+                sizeof(Header) + size_t(this->header->slotCount) * (sizeof(SlotHeader) + this->header->slotSize) > this->segmentSize) {
+            std::cerr << "[ShmRing] Shared memory segment '" << this->name << "' has an unknown layout!" << std::endl;
+            munmap(this->header, this->segmentSize);
+            this->header = nullptr;
+            return;
+        }
+    }
+
+    this->buffer = kj::heapArray<::capnp::word>(this->header->slotSize / sizeof(::capnp::word));
+    // only messages written from now on are read
+    this->cursor = this->header->head.load(std::memory_order_acquire);
+}
+
+ShmRing::~ShmRing()
+{
+    if (this->header) {
+        munmap(this->header, this->segmentSize);
+    }
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+    // processes still attached keep their mapping, the next one to open the topic creates a new segment
+    if (this->created) {
+        shm_unlink(this->name.c_str());
+    }
+}
+
+std::string ShmRing::toSegmentName(const std::string& topic)
+{
+    std::string segmentName = "/srgsim_";
+    for (char c : topic) {
+        segmentName += (c == '/') ? '_' : c;
+    }
+    return segmentName;
+}
+
+bool ShmRing::isValid() const
+{
+    return this->header != nullptr;
+}
+
+uint64_t ShmRing::getLostMessages() const
+{
+    return this->lostMessages;
+}
+
+ShmRing::SlotHeader* ShmRing::getSlot(uint64_t sequence)
+{
+    size_t slotStride = sizeof(SlotHeader) + this->header->slotSize;
+    char* slots = reinterpret_cast<char*>(this->header) + sizeof(Header);
+    return reinterpret_cast<SlotHeader*>(slots + (sequence % this->header->slotCount) * slotStride);
+}
+
+bool ShmRing::write(::capnp::MessageBuilder& msgBuilder)
+{
+    if (!this->header) {
+        return false;
+    }
+    size_t size = ::capnp::computeSerializedSizeInWords(msgBuilder) * sizeof(::capnp::word);
+    if (size > this->header->slotSize) {
+        std::cerr << "[ShmRing] Message of " << size << " bytes exceeds slot size of '" << this->name << "'!" << std::endl;
+        return false;
+    }
+
+    uint64_t sequence = this->header->head.fetch_add(1, std::memory_order_acq_rel);
+    SlotHeader* slot = this->getSlot(sequence);
+    slot->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    kj::ArrayOutputStream output(kj::arrayPtr(reinterpret_cast<kj::byte*>(slot + 1), size));
+    ::capnp::writeMessage(output, msgBuilder);
+    slot->size = size;
+    slot->sequence.store(sequence + 1, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::read(const std::function<void(::capnp::FlatArrayMessageReader&)>& callback)
+{
+    if (!this->header) {
+        return false;
+    }
+
+    uint64_t head = this->header->head.load(std::memory_order_acquire);
+    if (head < this->cursor) {
+        // the segment was reset by another process, start over with its next message
+        this->cursor = head;
+        return false;
+    }
+    if (head - this->cursor > this->header->slotCount) {
+        // lapped by the writers
+        this->lostMessages += head - this->cursor - this->header->slotCount;
+        this->cursor = head - this->header->slotCount;
+    }
+
+    while (this->cursor < head) {
+        SlotHeader* slot = this->getSlot(this->cursor);
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == this->cursor + 1) {
+            // the slot is copied before it is handed out, a writer lapping the reader meanwhile shows up in its sequence
+            uint64_t size = slot->size;
+            if (size <= this->header->slotSize) {
+                memcpy(this->buffer.begin(), slot + 1, size);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->sequence.load(std::memory_order_relaxed) != sequence || size > this->header->slotSize) {
+                // overwritten while copying
+                this->lostMessages++;
+                this->cursor++;
+                continue;
+            }
+            this->cursor++;
+            ::capnp::FlatArrayMessageReader msgReader(this->buffer.slice(0, size / sizeof(::capnp::word)));
+            callback(msgReader);
+            return true;
+        }
+        if (sequence < this->cursor + 1 && head - this->cursor <= this->header->slotCount / 2) {
+            // still being written
+            return false;
+        }
+        if (sequence < this->cursor + 1 && slot->sequence.load(std::memory_order_acquire) == this->cursor + 1) {
+            // published after all, read it with the next iteration
+            continue;
+        }
+        // overwritten already, or the writer of this slot died
+        this->lostMessages++;
+        this->cursor++;
+    }
+    return false;
+}
+} // namespace communication
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,77 @@
+#include "srg/sim/communication/ShmTransport.h"
+
+#include "srg/sim/communication/ShmRing.h"
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+ShmTransport::ShmTransport(uint32_t slotCount, uint32_t slotSize, std::chrono::microseconds pollInterval)
+        : slotCount(slotCount)
+        , slotSize(slotSize)
+        , pollInterval(pollInterval)
+        , running(false)
+        , receiver(nullptr)
+{
+}
+
+ShmTransport::~ShmTransport()
+{
+    if (this->receiver) {
+        this->running = false;
+        this->receiver->join();
+        delete this->receiver;
+    }
+    for (auto& entry : this->rings) {
+        delete entry.second;
+    }
+}
+
+ShmRing* ShmTransport::getRing(const std::string& topic)
+{
+    std::lock_guard<std::mutex> guard(this->ringMutex);
+    ShmRing*& ring = this->rings[topic];
+    if (!ring) {
+        ring = new ShmRing(topic, true, this->slotCount, this->slotSize);
+    }
+    return ring;
+}
+
+void ShmTransport::subscribe(const std::string& topic, Callback callback)
+{
+    std::lock_guard<std::mutex> guard(this->subscriptionMutex);
+    this->subscriptions.emplace_back(this->getRing(topic), callback);
+    if (!this->receiver) {
+        this->running = true;
+        this->receiver = new std::thread(&ShmTransport::receive, this);
+    }
+}
+
+void ShmTransport::send(const std::string& topic, ::capnp::MallocMessageBuilder& msgBuilder)
+{
+    // writing is lock-free, rings are only read by the receiver thread
+    this->getRing(topic)->write(msgBuilder);
+}
+
+void ShmTransport::receive()
+{
+    while (this->running) {
+        bool received = false;
+        {
+            std::lock_guard<std::mutex> guard(this->subscriptionMutex);
+            for (auto& subscription : this->subscriptions) {
+                while (subscription.first->read(subscription.second)) {
+                    received = true;
+                }
+            }
+        }
+        if (!received) {
+            std::this_thread::sleep_for(this->pollInterval);
+        }
+    }
+}
+} // namespace communication
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,67 @@
+#include "srg/sim/communication/UDPTransport.h"
+
+#include <capnzero/Publisher.h>
+#include <capnzero/Subscriber.h>
+
+namespace srg
+{
+namespace sim
+{
+namespace communication
+{
+UDPTransport::Subscription::Subscription(Callback callback)
+        : callback(callback)
+{
+}
+
+void UDPTransport::Subscription::onMessage(::capnp::FlatArrayMessageReader& msg)
+{
+    this->callback(msg);
+}
+
+UDPTransport::UDPTransport(const std::string& address)
+        : address(address)
+{
+    this->ctx = zmq_ctx_new();
+}
+
+UDPTransport::~UDPTransport()
+{
+    for (capnzero::Subscriber* subscriber : this->subscribers) {
+        delete subscriber;
+    }
+    for (Subscription* subscription : this->subscriptions) {
+        delete subscription;
+    }
+    for (auto& entry : this->publishers) {
+        delete entry.second;
+    }
+    zmq_ctx_term(this->ctx);
+}
+
+void UDPTransport::subscribe(const std::string& topic, Callback callback)
+{
+    Subscription* subscription = new Subscription(callback);
+    capnzero::Subscriber* subscriber = new capnzero::Subscriber(this->ctx, capnzero::Protocol::UDP);
+    subscriber->setTopic(topic);
+    subscriber->addAddress(this->address);
+    subscriber->setReceiveQueueSize(1000);
+    subscriber->subscribe(&Subscription::onMessage, subscription);
+    this->subscriptions.push_back(subscription);
+    this->subscribers.push_back(subscriber);
+}
+
+void UDPTransport::send(const std::string& topic, ::capnp::MallocMessageBuilder& msgBuilder)
+{
+    capnzero::Publisher*& publisher = this->publishers[topic];
+    if (!publisher) {
+        publisher = new capnzero::Publisher(this->ctx, capnzero::Protocol::UDP);
+        publisher->setDefaultTopic(topic);
+        publisher->addAddress(this->address);
+        publisher->setSendQueueSize(1000);
+    }
+    publisher->send(msgBuilder);
+}
+} // namespace communication
+} // namespace sim
+} // namespace srg
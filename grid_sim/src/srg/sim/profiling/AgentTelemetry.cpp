@@ -0,0 +1,123 @@
+#include "srg/sim/profiling/AgentTelemetry.h"
+
+#include <iostream>
+#include <sstream>
+
+namespace srg
+{
+namespace sim
+{
+namespace profiling
+{
+AgentLatencies::AgentLatencies()
+        : received(0)
+        , dropped(0)
+        , clockSkewed(0)
+        , lastApply(0)
+{
+}
+
+AgentTelemetry::~AgentTelemetry()
+{
+    for (auto& entry : this->agents) {
+        delete entry.second;
+    }
+}
+
+AgentLatencies& AgentTelemetry::getOrCreateLatencies(essentials::IdentifierConstPtr agentID)
+{
+    std::lock_guard<std::mutex> guard(this->agentsMutex);
+    auto entry = this->agents.find(agentID);
+    if (entry == this->agents.end()) {
+        entry = this->agents.emplace(agentID, new AgentLatencies()).first;
+    }
+    return *entry->second;
+}
+
+const AgentLatencies* AgentTelemetry::getLatencies(essentials::IdentifierConstPtr agentID) const
+{
+    std::lock_guard<std::mutex> guard(this->agentsMutex);
+    auto entry = this->agents.find(agentID);
+    if (entry == this->agents.end()) {
+        return nullptr;
+    }
+    return entry->second;
+}
+
+void AgentTelemetry::recordReceived(const containers::SimCommand& simCommand)
+{
+    AgentLatencies& latencies = this->getOrCreateLatencies(simCommand.senderID);
+    latencies.received.fetch_add(1, std::memory_order_relaxed);
+    if (simCommand.receiveTime < simCommand.timestamp) {
+        latencies.clockSkewed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    latencies.sendToReceive.record(std::chrono::duration_cast<std::chrono::nanoseconds>(simCommand.receiveTime - simCommand.timestamp));
+}
+
+void AgentTelemetry::countDropped(essentials::IdentifierConstPtr agentID)
+{
+    this->getOrCreateLatencies(agentID).dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AgentTelemetry::recordApplied(const containers::SimCommand& simCommand)
+{
+    AgentLatencies& latencies = this->getOrCreateLatencies(simCommand.senderID);
+    std::chrono::system_clock::duration now = std::chrono::system_clock::now().time_since_epoch();
+    latencies.receiveToApply.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - simCommand.receiveTime));
+    latencies.lastApply = now;
+}
+
+void AgentTelemetry::recordPerceptionSent(essentials::IdentifierConstPtr agentID)
+{
+    std::lock_guard<std::mutex> guard(this->agentsMutex);
+    auto entry = this->agents.find(agentID);
+    if (entry == this->agents.end() || entry->second->lastApply.count() == 0) {
+        return;
+    }
+    entry->second->applyToPerception.record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch() - entry->second->lastApply));
+    entry->second->lastApply = std::chrono::system_clock::duration(0);
+}
+
+void AgentTelemetry::writeJSON(std::ostream& os) const
+{
+    std::lock_guard<std::mutex> guard(this->agentsMutex);
+    os << "{";
+    bool first = true;
+    for (auto& entry : this->agents) {
+        const AgentLatencies& latencies = *entry.second;
+        os << (first ? "\n" : ",\n") << "    \"" << entry.first << "\": {\n"
+           << "      \"received\": " << latencies.received.load(std::memory_order_relaxed) << ",\n"
+           << "      \"dropped\": " << latencies.dropped.load(std::memory_order_relaxed) << ",\n"
+           << "      \"clock_skewed\": " << latencies.clockSkewed.load(std::memory_order_relaxed) << ",\n"
+           << "      \"send_to_receive\": ";
+        latencies.sendToReceive.writeJSON(os);
+        os << ",\n      \"receive_to_apply\": ";
+        latencies.receiveToApply.writeJSON(os);
+        os << ",\n      \"apply_to_perception\": ";
+        latencies.applyToPerception.writeJSON(os);
+        os << "\n    }";
+        first = false;
+    }
+    os << "\n  }";
+}
+
+void AgentTelemetry::writeCSV(std::ostream& os) const
+{
+    std::lock_guard<std::mutex> guard(this->agentsMutex);
+    for (auto& entry : this->agents) {
+        const AgentLatencies& latencies = *entry.second;
+        std::stringstream name;
+        name << "agent." << entry.first;
+        os << "# " << name.str() << " received=" << latencies.received.load(std::memory_order_relaxed)
+           << " dropped=" << latencies.dropped.load(std::memory_order_relaxed)
+           << " clock_skewed=" << latencies.clockSkewed.load(std::memory_order_relaxed) << "\n";
+        latencies.sendToReceive.writeCSV(os, name.str() + ".send_to_receive");
+        latencies.receiveToApply.writeCSV(os, name.str() + ".receive_to_apply");
+        latencies.applyToPerception.writeCSV(os, name.str() + ".apply_to_perception");
+    }
+}
+} // namespace profiling
+} // namespace sim
+} // namespace srg
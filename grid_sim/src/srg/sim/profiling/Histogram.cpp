@@ -0,0 +1,154 @@
+#include "srg/sim/profiling/Histogram.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace srg
+{
+namespace sim
+{
+namespace profiling
+{
+const uint32_t Histogram::SUB_BUCKETS;
+const uint32_t Histogram::BUCKET_COUNT;
+
+Histogram::Histogram()
+{
+    this->reset();
+}
+
+void Histogram::reset()
+{
+    for (auto& bucket : this->buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    this->count.store(0, std::memory_order_relaxed);
+    this->sum.store(0, std::memory_order_relaxed);
+    this->max.store(0, std::memory_order_relaxed);
+}
+
+uint32_t Histogram::toBucket(uint64_t nanoseconds)
+{
+    if (nanoseconds < SUB_BUCKETS) {
+        return static_cast<uint32_t>(nanoseconds);
+    }
+    uint32_t exponent = 63 - __builtin_clzll(nanoseconds);
+    uint32_t subBucket = static_cast<uint32_t>(nanoseconds >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    return (exponent - 2) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t Histogram::bucketUpperBound(uint32_t bucket)
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    uint32_t exponent = bucket / SUB_BUCKETS + 2;
+    uint64_t subBucket = bucket % SUB_BUCKETS;
+    uint64_t lowerBound = (SUB_BUCKETS + subBucket) << (exponent - 3);
+    return lowerBound + (uint64_t(1) << (exponent - 3)) - 1;
+}
+
+void Histogram::record(uint64_t nanoseconds)
+{
+    this->buckets[toBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    this->count.fetch_add(1, std::memory_order_relaxed);
+    this->sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    uint64_t currentMax = this->max.load(std::memory_order_relaxed);
+    while (nanoseconds > currentMax && !this->max.compare_exchange_weak(currentMax, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::record(std::chrono::nanoseconds duration)
+{
+    this->record(duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0);
+}
+
+uint64_t Histogram::getCount() const
+{
+    return this->count.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::getSum() const
+{
+    return this->sum.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::getMax() const
+{
+    return this->max.load(std::memory_order_relaxed);
+}
+
+double Histogram::getMean() const
+{
+    uint64_t count = this->getCount();
+    return count == 0 ? 0.0 : double(this->getSum()) / double(count);
+}
+
+uint64_t Histogram::getBucketCount(uint32_t bucket) const
+{
+    return this->buckets[bucket].load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::getQuantile(double quantile) const
+{
+    uint64_t count = this->getCount();
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(quantile * double(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += this->getBucketCount(i);
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), this->getMax());
+        }
+    }
+    return this->getMax();
+}
+
+void Histogram::writeJSON(std::ostream& os) const
+{
+    os << "{\"count\": " << this->getCount() << ", \"mean_ns\": " << this->getMean() << ", \"p50_ns\": " << this->getQuantile(0.5)
+       << ", \"p90_ns\": " << this->getQuantile(0.9) << ", \"p99_ns\": " << this->getQuantile(0.99) << ", \"max_ns\": " << this->getMax()
+       << ", \"buckets\": [";
+    bool first = true;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        uint64_t bucketCount = this->getBucketCount(i);
+        if (bucketCount == 0) {
+            continue;
+        }
+        os << (first ? "" : ", ") << "[" << bucketUpperBound(i) << ", " << bucketCount << "]";
+        first = false;
+    }
+    os << "]}";
+}
+
+void Histogram::writeCSV(std::ostream& os, const std::string& name) const
+{
+    os << name << "," << this->getCount() << "," << this->getMean() << "," << this->getQuantile(0.5) << "," << this->getQuantile(0.9) << ","
+       << this->getQuantile(0.99) << "," << this->getMax() << ",";
+    bool first = true;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        uint64_t bucketCount = this->getBucketCount(i);
+        if (bucketCount == 0) {
+            continue;
+        }
+        os << (first ? "" : ";") << bucketUpperBound(i) << ":" << bucketCount;
+        first = false;
+    }
+    os << "\n";
+}
+
+ScopedTimer::ScopedTimer(Histogram& histogram)
+        : histogram(histogram)
+        , start(std::chrono::steady_clock::now())
+{
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    this->histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start));
+}
+} // namespace profiling
+} // namespace sim
+} // namespace srg
@@ -0,0 +1,233 @@
+#include "srg/sim/profiling/TickProfiler.h"
+
+#include <essentials/SystemConfig.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace srg
+{
+namespace sim
+{
+namespace profiling
+{
+std::atomic<bool> TickProfiler::dumpRequested(false);
+
+TickProfiler::TickProfiler()
+        : overruns(0)
+        , commands(0)
+        , perceptionMessages(0)
+        , perceptionBytes(0)
+        , lastDump(std::chrono::steady_clock::now())
+{
+    essentials::SystemConfig& sc = essentials::SystemConfig::getInstance();
+    this->dumpFile = sc["SRGSim"]->tryGet<std::string>("", "SRGSim.Profiling.dumpFile", NULL);
+    this->dumpInterval = std::chrono::seconds(sc["SRGSim"]->tryGet<uint32_t>(10, "SRGSim.Profiling.dumpInterval", NULL));
+}
+
+TickProfiler::~TickProfiler()
+{
+    for (auto& entry : this->agentPerceptions) {
+        delete entry.second;
+    }
+}
+
+Histogram& TickProfiler::getHistogram(Phase phase)
+{
+    return this->phases[static_cast<int>(phase)];
+}
+
+Histogram& TickProfiler::getHistogram(containers::Action action)
+{
+    return this->actions[action];
+}
+
+Histogram& TickProfiler::getPerceptionHistogram(essentials::IdentifierConstPtr agentID)
+{
+    auto entry = this->agentPerceptions.find(agentID);
+    if (entry == this->agentPerceptions.end()) {
+        entry = this->agentPerceptions.emplace(agentID, new Histogram()).first;
+    }
+    return *entry->second;
+}
+
+AgentTelemetry& TickProfiler::getAgentTelemetry()
+{
+    return this->agentTelemetry;
+}
+
+void TickProfiler::countOverrun()
+{
+    this->overruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t TickProfiler::getOverruns() const
+{
+    return this->overruns.load(std::memory_order_relaxed);
+}
+
+void TickProfiler::countCommand()
+{
+    this->commands.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t TickProfiler::getCommands() const
+{
+    return this->commands.load(std::memory_order_relaxed);
+}
+
+void TickProfiler::countPerception(size_t bytes)
+{
+    this->perceptionMessages.fetch_add(1, std::memory_order_relaxed);
+    this->perceptionBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+uint64_t TickProfiler::getPerceptionMessages() const
+{
+    return this->perceptionMessages.load(std::memory_order_relaxed);
+}
+
+uint64_t TickProfiler::getPerceptionBytes() const
+{
+    return this->perceptionBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t TickProfiler::getTicks() const
+{
+    return this->phases[static_cast<int>(Phase::Tick)].getCount();
+}
+
+void TickProfiler::requestDump(int sig)
+{
+    dumpRequested = true;
+}
+
+void TickProfiler::dumpPeriodically()
+{
+    if (this->dumpFile.empty()) {
+        return;
+    }
+    if (!dumpRequested.exchange(false) && std::chrono::steady_clock::now() - this->lastDump < this->dumpInterval) {
+        return;
+    }
+    this->dump();
+}
+
+void TickProfiler::dump()
+{
+    this->lastDump = std::chrono::steady_clock::now();
+    if (this->dumpFile.empty()) {
+        return;
+    }
+
+    // write to a temporary file first, so that readers never see a partial dump
+    std::string tmpFile = this->dumpFile + ".tmp";
+    {
+        std::ofstream os(tmpFile, std::ios::trunc);
+        if (!os) {
+            std::cerr << "[TickProfiler] Unable to write '" << tmpFile << "'!" << std::endl;
+            return;
+        }
+        bool json = this->dumpFile.size() >= 5 && this->dumpFile.compare(this->dumpFile.size() - 5, 5, ".json") == 0;
+        if (json) {
+            this->writeJSON(os);
+        } else {
+            this->writeCSV(os);
+        }
+    }
+    if (std::rename(tmpFile.c_str(), this->dumpFile.c_str()) != 0) {
+        std::cerr << "[TickProfiler] Unable to rename '" << tmpFile << "' to '" << this->dumpFile << "'!" << std::endl;
+    }
+}
+
+void TickProfiler::writeJSON(std::ostream& os) const
+{
+    os << "{\n  \"ticks\": " << this->getTicks() << ",\n  \"overruns\": " << this->getOverruns() << ",\n  \"commands\": " << this->getCommands()
+       << ",\n  \"perceptionMessages\": " << this->getPerceptionMessages() << ",\n  \"perceptionBytes\": " << this->getPerceptionBytes() << ",\n  \"phases\": {";
+    for (int i = 0; i < static_cast<int>(Phase::Last); i++) {
+        os << (i == 0 ? "\n" : ",\n") << "    \"" << static_cast<Phase>(i) << "\": ";
+        this->phases[i].writeJSON(os);
+    }
+    os << "\n  },\n  \"commands\": {";
+    for (int i = 0; i <= containers::Action::CLOSE; i++) {
+        os << (i == 0 ? "\n" : ",\n") << "    \"" << static_cast<containers::Action>(i) << "\": ";
+        this->actions[i].writeJSON(os);
+    }
+    os << "\n  },\n  \"perceptions\": {";
+    bool first = true;
+    for (auto& entry : this->agentPerceptions) {
+        os << (first ? "\n" : ",\n") << "    \"" << entry.first << "\": ";
+        entry.second->writeJSON(os);
+        first = false;
+    }
+    os << "\n  },\n  \"agents\": ";
+    this->agentTelemetry.writeJSON(os);
+    os << "\n}\n";
+}
+
+void TickProfiler::writeCSV(std::ostream& os) const
+{
+    os << "# ticks=" << this->getTicks() << " overruns=" << this->getOverruns() << " commands=" << this->getCommands()
+       << " perceptionMessages=" << this->getPerceptionMessages() << " perceptionBytes=" << this->getPerceptionBytes() << "\n";
+    os << "histogram,count,mean_ns,p50_ns,p90_ns,p99_ns,max_ns,buckets\n";
+    for (int i = 0; i < static_cast<int>(Phase::Last); i++) {
+        std::stringstream name;
+        name << "phase." << static_cast<Phase>(i);
+        this->phases[i].writeCSV(os, name.str());
+    }
+    for (int i = 0; i <= containers::Action::CLOSE; i++) {
+        std::stringstream name;
+        name << "command." << static_cast<containers::Action>(i);
+        this->actions[i].writeCSV(os, name.str());
+    }
+    for (auto& entry : this->agentPerceptions) {
+        std::stringstream name;
+        name << "perception." << entry.first;
+        entry.second->writeCSV(os, name.str());
+    }
+    this->agentTelemetry.writeCSV(os);
+}
+
+/**
+ * For getting a string representation of a profiling phase.
+ * @param os Outputstream
+ * @param phase Phase of a simulator iteration.
+ * @return Outputstream
+ */
+std::ostream& operator<<(std::ostream& os, const Phase& phase)
+{
+    switch (phase) {
+    case Phase::Tick:
+        os << "tick";
+        break;
+    case Phase::GUI:
+        os << "gui";
+        break;
+    case Phase::Commands:
+        os << "commands";
+        break;
+    case Phase::Displacement:
+        os << "displacement";
+        break;
+    case Phase::Perception:
+        os << "perception";
+        break;
+    case Phase::Serialization:
+        os << "serialization";
+        break;
+    case Phase::Send:
+        os << "send";
+        break;
+    case Phase::PathQuery:
+        os << "pathQuery";
+        break;
+    default:
+        os.setstate(std::ios_base::failbit);
+    }
+    return os;
+}
+} // namespace profiling
+} // namespace sim
+} // namespace srg
@@ -1,21 +1,25 @@
 #pragma once
 
-#include "srg/viz/Marker.h"
-#include "srg/viz/SpriteType.h"
-
-#include <srg/World.h>
-#include <srg/world/RoomType.h>
+#include "srg/viz/HUD.h"
+#include "srg/viz/SnapshotBuffer.h"
+#include "srg/viz/WorldRenderer.h"
+#include "srg/viz/WorldSnapshot.h"
 
 #include <essentials/SystemConfig.h>
 
 #include <SFML/Graphics.hpp>
 
+#include <atomic>
 #include <string>
-#include <unordered_map>
-#include <mutex>
+#include <thread>
 
 namespace srg
 {
+/**
+ * Renders the world in its own thread with the frame rate configured as "fps" in the window config.
+ * The simulator publishes a snapshot of the world each iteration and never waits for the rendering.
+ * [F3] toggles the performance overlay.
+ */
 class GUI
 {
 public:
@@ -23,27 +27,23 @@ public:
 
     ~GUI();
 
-    void addMarker(viz::Marker marker);
-    void draw(srg::World* world);
+    /**
+     * Hands the snapshot over to the render thread, called by the simulator thread.
+     */
+    void publish(const viz::WorldSnapshot& snapshot);
 
 private:
+    void run(std::string windowName);
     void readWindowConfig();
     void storeWindowConfig();
-    sf::Sprite getSprite(viz::SpriteType type);
-    sf::Sprite getSprite(world::RoomType type);
-    sf::Sprite getSprite(std::shared_ptr<const world::Object> object);
-    void scaleSprite(const World* world);
-    void handleSFMLEvents(const World* world);
-    void calculateScale();
-    void calculateSpriteSize(const World* world);
-    void updateView(const World* world, int width, int height);
+    void handleSFMLEvents();
+    void calculateSpriteSize();
+    void updateView(int width, int height);
 
     essentials::Configuration* windowConfig;
     static const std::string configFolder;
     static const std::string windowConfigFile;
 
-    uint32_t textureSize = 60;
-    float scaleFactor = 0;
     float scaledSpriteSize = 0;
     float camOffsetX;
     float camOffsetY;
@@ -51,13 +51,20 @@ private:
     float mousePosOldY;
     float zoomFactor;
     bool dragging = false;
+    uint32_t fps;
+    /**
+     * Below this number of pixels per cell, rooms and aggregated objects are rendered instead of sprites.
+     */
+    float lodPixelsPerCell;
+    bool hudVisible;
+    std::string hudFont;
 
-    sf::Sprite sprites[static_cast<int>(viz::SpriteType::Last)];
-
-    sf::Texture* texture;
+    viz::SnapshotBuffer snapshots;
+    viz::WorldRenderer* renderer;
+    viz::HUD* hud;
     sf::RenderWindow* window;
-    std::vector<viz::Marker> markers;
 
-    std::recursive_mutex _mtx;
+    std::atomic<bool> running;
+    std::thread* renderThread;
 };
-} // namespace srg
\ No newline at end of file
+} // namespace srg
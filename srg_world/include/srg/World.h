@@ -14,6 +14,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <random>
 #include <unordered_map>
 #include <vector>
 
@@ -29,6 +30,9 @@ class Cell;
 class Object;
 class Agent;
 class Room;
+class MapFile;
+struct ScenarioObject;
+struct Checkpoint;
 } // namespace world
 
 /**
@@ -40,11 +44,16 @@ class World
 {
 public:
     World(essentials::IDManager& idManager);
-    World(std::string tmxMapFile, essentials::IDManager& idManager);
+    /**
+     * @param mapFile A TMX map, which is compiled into ~/.grid_sim/maps on first use, or a compiled .srgmap file.
+     * @param chunkSize Splits the grid into chunks of chunkSize x chunkSize cells, 0 keeps the whole world resident and active.
+     */
+    World(std::string mapFile, essentials::IDManager& idManager, uint32_t chunkSize = 0);
     ~World();
 
     std::shared_ptr<world::Cell> addCell(uint32_t x, uint32_t y, world::Room* room);
     std::shared_ptr<const world::Cell> getCell(const world::Coordinate& coordinate) const;
+    std::shared_ptr<world::Cell> editCell(const world::Coordinate& coordinate);
 
     uint32_t getSizeX() const;
     uint32_t getSizeY() const;
@@ -59,10 +68,27 @@ public:
     std::shared_ptr<world::Object> editObject(essentials::IdentifierConstPtr id);
     void updateCell(world::Coordinate coordinate, std::vector<std::shared_ptr<world::Object>> objects, int64_t time);
     std::shared_ptr<world::Object> createOrUpdateObject(std::shared_ptr<world::Object> tmpObject);
+    /**
+     * Same as above, but without a temporary object and without touching contained objects.
+     */
+    std::shared_ptr<world::Object> createOrUpdateObject(essentials::IdentifierConstPtr id, world::ObjectType type, world::ObjectState state);
     std::vector<std::shared_ptr<world::Object>> removeUnknownObjects();
+    /**
+     * @return True if the object was placed or, for a chunk that is not resident yet, queued to be placed and checked when it is materialized.
+     */
     bool placeObject(std::shared_ptr<world::Object> object, world::Coordinate coordinate);
+    /**
+     * Creates and places all objects with one lock, objects that are already placed are skipped.
+     * @param deferred Number of objects queued for chunks that are not resident yet.
+     * @return The number of placed objects, without the deferred ones.
+     */
+    uint32_t placeObjects(const std::vector<world::ScenarioObject>& scenarioObjects, essentials::IDManager& idManager, uint32_t& deferred);
     void moveObject(essentials::IdentifierConstPtr id, world::Direction direction);
     void displaceObject();
+    /**
+     * Moves the cells whose objects changed since the last call into the given list.
+     */
+    void takeChangedCells(std::vector<const world::Cell*>& cells);
 
     // agents
     std::shared_ptr<world::Agent> spawnAgent(essentials::IdentifierConstPtr id, world::ObjectType agentType);
@@ -70,14 +96,64 @@ public:
     std::shared_ptr<world::Agent> editAgent(essentials::IdentifierConstPtr id);
     bool addAgent(std::shared_ptr<world::Agent> agent);
 
+    // chunks
+    uint32_t getChunkSize() const;
+    uint32_t getChunkCount() const;
+    /**
+     * @return The index of the chunk containing the coordinate, -1 if chunks are disabled or the coordinate is outside of the world.
+     */
+    int64_t getChunkIndex(const world::Coordinate& coordinate) const;
+    bool isChunkActive(uint32_t chunk) const;
+    bool isChunkResident(uint32_t chunk) const;
+    uint32_t getActiveChunkCount() const;
+    uint32_t getResidentChunkCount() const;
+    /**
+     * Activates the chunks within range of an agent and deactivates all others. Activated chunks are materialized.
+     */
+    void updateActiveChunks(uint32_t range);
+    /**
+     * Collects the resident cells of the chunk, ordered by their coordinates.
+     */
+    void collectChunkCells(uint32_t chunk, std::vector<const world::Cell*>& cells) const;
+
+    // checkpoints
+    /**
+     * Copies the dynamic state, the map itself is not part of the checkpoint.
+     */
+    void captureCheckpoint(world::Checkpoint& checkpoint) const;
+    /**
+     * Recreates the checkpointed objects and moves them into their containers.
+     * @param restoredAgents The restored agents, to be simulated again.
+     * @return False if the checkpoint doesn't fit the map of this world.
+     */
+    bool restoreCheckpoint(const world::Checkpoint& checkpoint, essentials::IDManager& idManager, std::vector<std::shared_ptr<world::Agent>>& restoredAgents);
+
+    // randomness, all random decisions of the world are taken from one engine, so they are part of checkpoints
+    /**
+     * @return Random number in [0, bound), 0 for a bound of 0.
+     */
+    uint32_t random(uint32_t bound);
+    void seedRandom(uint32_t seed);
+
     // other
     void openDoor(essentials::IdentifierConstPtr id);
     void closeDoor(essentials::IdentifierConstPtr id);
     const std::unordered_map<essentials::IdentifierConstPtr, world::Room*> getRooms() const;
     const std::vector<world::Room*> getRooms(world::RoomType type) const;
 
+    /**
+     * Counts changes of cells and doors, so caches of the layout, e.g., the room graph of the path planner, know when to rebuild.
+     */
+    uint64_t getTopologyVersion() const;
 
 private:
+    void loadMap(const world::MapFile& map, essentials::IDManager& idManager, bool lazy);
+    void initChunks(bool lazy);
+    void materializeChunk(uint32_t chunk);
+    bool isPlacementDeferred(const world::Coordinate& coordinate) const;
+    std::shared_ptr<world::Cell> findCell(const world::Coordinate& coordinate) const;
+    world::Coordinate getRandomActiveCoordinate();
+    void loadTmx(std::string tmxMapFile, essentials::IDManager& idManager);
     bool isPlacementAllowed(std::shared_ptr<const world::Cell> cell, world::ObjectType objectType) const;
     std::shared_ptr<world::Cell> getNeighbourCell(const world::Direction& direction, std::shared_ptr<world::Object> object);
     world::Room* addRoom(std::string name, essentials::IdentifierConstPtr id);
@@ -98,5 +174,25 @@ private:
     std::unordered_map<essentials::IdentifierConstPtr, std::shared_ptr<world::Object>> objectCache;
     std::unordered_map<essentials::IdentifierConstPtr, std::shared_ptr<world::Agent>> agents;
     std::unordered_map<essentials::IdentifierConstPtr, world::Room*> rooms;
+    std::vector<world::Cell*> changedCells;
+    std::mt19937 randomEngine;
+
+    /**
+     * Chunks are indexed by (x / chunkSize) * chunksY + y / chunkSize. Cells of a compiled map are only created
+     * when their chunk is first accessed or activated, objects placed into other chunks wait in pendingObjects.
+     * Only chunks with an agent in range are active, i.e., get displaced objects and updated snapshots.
+     */
+    world::MapFile* map; /**< Kept open while chunks are not materialized. */
+    std::vector<world::Room*> mapRooms;
+    uint32_t chunkSize;
+    uint32_t chunksX;
+    uint32_t chunksY;
+    std::vector<bool> residentChunks;
+    std::vector<bool> activeChunks;
+    std::vector<uint32_t> activeChunkList;
+    uint32_t residentChunkCount;
+    std::unordered_map<uint32_t, std::vector<std::pair<std::shared_ptr<world::Object>, world::Coordinate>>> pendingObjects;
+
+    uint64_t topologyVersion;
 };
 } // namespace srg
\ No newline at end of file
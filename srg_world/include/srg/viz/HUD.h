@@ -0,0 +1,79 @@
+#pragma once
+
+#include "srg/viz/WorldSnapshot.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace srg
+{
+namespace viz
+{
+/**
+ * Performance overlay with the current value and a rolling graph per metric.
+ * Without the font, only the graphs are drawn.
+ */
+class HUD
+{
+public:
+    HUD(std::string fontFile);
+
+    /**
+     * Adds the stats of a new snapshot, rates are calculated against the previous one.
+     */
+    void update(const WorldSnapshot& snapshot);
+    void addFrameTime(std::chrono::steady_clock::duration frameTime);
+    /**
+     * Draws the overlay in the top left corner, independent of the view of the target.
+     */
+    void draw(sf::RenderTarget& target);
+
+private:
+    enum Metric
+    {
+        TickTime = 0,
+        FrameTime,
+        Commands,
+        PerceptionMessages,
+        PerceptionBytes,
+        Agents,
+        ActiveChunks,
+        ResidentChunks,
+        WorldLockWait,
+        MetricCount
+    };
+
+    struct Series
+    {
+        Series();
+        void add(float sample);
+        float getMax() const;
+
+        std::string label;
+        std::vector<float> samples;
+        size_t next;
+        size_t count;
+        float latest;
+    };
+
+    static const size_t sampleCount = 300;
+    static const int rowHeight = 36;
+    static const int width = 320;
+
+    Series series[MetricCount];
+    uint64_t overruns;
+
+    bool hasFont;
+    sf::Font font;
+    sf::Text text;
+    sf::RectangleShape background;
+    sf::VertexArray graphs;
+
+    uint64_t lastTick;
+    SimulatorStats lastStats;
+};
+} // namespace viz
+} // namespace srg
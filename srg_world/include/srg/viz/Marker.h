@@ -4,6 +4,8 @@
 
 #include <srg/world/Coordinate.h>
 
+#include <cstdint>
+
 namespace srg
 {
 namespace viz
@@ -11,10 +13,16 @@ namespace viz
 class Marker
 {
 public:
-    Marker(world::Coordinate coordinate);
+    /**
+     * @param id Markers with the same ID replace each other, 0 for anonymous markers.
+     * @param lifetime Number of simulator iterations the marker is shown, 0 until it is removed.
+     */
+    Marker(world::Coordinate coordinate, SpriteType type = SpriteType::Default, uint64_t id = 0, uint32_t lifetime = 1);
 
     SpriteType type;
     world::Coordinate coordinate;
+    uint64_t id;
+    uint32_t lifetime;
 };
 } // namespace viz
-} // namespace srg
\ No newline at end of file
+} // namespace srg
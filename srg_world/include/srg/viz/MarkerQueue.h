@@ -0,0 +1,51 @@
+#pragma once
+
+#include "srg/viz/Marker.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace srg
+{
+namespace viz
+{
+/**
+ * Lock-free multi producer, single consumer queue of marker updates. Producers push
+ * batches from any thread, the consumer takes all pending batches at once in submission order.
+ */
+class MarkerQueue
+{
+public:
+    struct Batch
+    {
+        Batch()
+                : clear(false)
+                , next(nullptr)
+        {
+        }
+
+        bool clear; /**< Removes all markers before adding the markers of this batch. */
+        std::vector<uint64_t> removedIDs;
+        std::vector<Marker> markers;
+        Batch* next;
+    };
+
+    MarkerQueue();
+    ~MarkerQueue();
+
+    /**
+     * Takes ownership of the batch.
+     */
+    void push(Batch* batch);
+    /**
+     * Takes all pending batches, the caller owns and has to delete them.
+     * Only one thread may call this method.
+     */
+    std::vector<Batch*> takeAll();
+
+private:
+    std::atomic<Batch*> head;
+};
+} // namespace viz
+} // namespace srg
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "srg/viz/SnapshotBuffer.h"
+#include "srg/viz/WorldSnapshot.h"
+
+#include <SFML/Graphics/Image.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace srg
+{
+namespace viz
+{
+/**
+ * Records snapshots as frames, without a window. A render thread draws the latest snapshot
+ * into an offscreen texture and hands the image over to an encoder thread through a bounded queue.
+ * Frames are dropped if the encoder falls behind, publishing never blocks.
+ */
+class Recorder
+{
+public:
+    enum class Format
+    {
+        PNG, /**< One frame_<tick>.png per frame. */
+        Raw  /**< RGBA frames of width x height appended to frames.rgba. */
+    };
+
+    Recorder(std::string directory, Format format, uint32_t width, uint32_t height, size_t queueSize, float lodPixelsPerCell);
+    ~Recorder();
+
+    /**
+     * Hands the snapshot over to the render thread, called by the simulator thread.
+     */
+    void publish(const WorldSnapshot& snapshot);
+    uint64_t getWrittenFrames() const;
+    uint64_t getDroppedFrames() const;
+
+private:
+    struct Frame
+    {
+        uint64_t tick;
+        sf::Image image;
+    };
+
+    void renderLoop();
+    void encodeLoop();
+
+    std::string directory;
+    Format format;
+    uint32_t width;
+    uint32_t height;
+    size_t queueSize;
+    float lodPixelsPerCell;
+
+    SnapshotBuffer snapshots;
+    std::deque<Frame*> frames;
+    std::mutex framesMutex;
+    std::condition_variable framesCondition;
+
+    std::atomic<bool> running;
+    std::atomic<uint64_t> writtenFrames;
+    std::atomic<uint64_t> droppedFrames;
+    std::thread* renderThread;
+    std::thread* encoderThread;
+};
+} // namespace viz
+} // namespace srg
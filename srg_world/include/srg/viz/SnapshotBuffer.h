@@ -0,0 +1,48 @@
+#pragma once
+
+#include "srg/viz/WorldSnapshot.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace srg
+{
+namespace viz
+{
+/**
+ * Triple buffer handing snapshots from the simulator thread to one rendering thread.
+ * Publishing never waits for the reader, older snapshots that were not read yet are overwritten.
+ */
+class SnapshotBuffer
+{
+public:
+    SnapshotBuffer();
+    ~SnapshotBuffer();
+
+    /**
+     * Copies the snapshot, called by the simulator thread.
+     */
+    void publish(const WorldSnapshot& snapshot);
+    /**
+     * Makes the latest published snapshot the current one.
+     * @param timeout How long to wait for a new snapshot, zero to return immediately.
+     * @return True, if the current snapshot was replaced.
+     */
+    bool update(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+    const WorldSnapshot& getCurrent() const;
+    /**
+     * Wakes a reader waiting in update, e.g., for shutting down.
+     */
+    void notify();
+
+private:
+    WorldSnapshot* building;
+    WorldSnapshot* published;
+    WorldSnapshot* current;
+    bool fresh;
+    std::mutex mutex;
+    std::condition_variable freshCondition;
+};
+} // namespace viz
+} // namespace srg
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "srg/viz/Marker.h"
+#include "srg/viz/MarkerQueue.h"
+#include "srg/viz/SpriteType.h"
+#include "srg/viz/WorldSnapshot.h"
+
+#include <srg/world/RoomType.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace srg
+{
+class World;
+namespace world
+{
+class Cell;
+class Object;
+} // namespace world
+namespace viz
+{
+/**
+ * Copies what is rendered from the world into snapshots, used by the simulator thread.
+ */
+class SnapshotBuilder
+{
+public:
+    SnapshotBuilder();
+
+    /**
+     * Markers are added to the next snapshot and kept for their lifetime. The marker methods are lock-free
+     * and can be called from any thread.
+     */
+    void addMarker(Marker marker);
+    void addMarkers(std::vector<Marker> markers);
+    void removeMarker(uint64_t id);
+    void clearMarkers();
+    /**
+     * Drops the submitted marker updates without applying them, if no snapshots are built.
+     */
+    void discardMarkers();
+    /**
+     * @param tick Iteration of the simulator, snapshots are not necessarily built for every iteration.
+     */
+    void build(World* world, WorldSnapshot& snapshot, uint64_t tick);
+
+    static SpriteType getSpriteType(world::RoomType type);
+    static SpriteType getSpriteType(std::shared_ptr<const world::Object> object);
+
+private:
+    struct ActiveMarker
+    {
+        ActiveMarker(const Marker& marker, uint64_t expiry)
+                : marker(marker)
+                , expiry(expiry)
+        {
+        }
+
+        Marker marker;
+        uint64_t expiry; /**< Tick the marker is removed in, 0 for never. */
+    };
+
+    std::shared_ptr<const std::vector<RoomArea>> createRoomAreas(World* world);
+    void updateMarkers();
+    void appendObjectSprites(const world::Cell* cell, std::vector<SpriteInstance>& sprites);
+    void collectChunkSprites(World* world, std::vector<SpriteInstance>& sprites);
+
+    std::shared_ptr<const std::vector<SpriteInstance>> staticSprites;
+    std::shared_ptr<const std::vector<RoomArea>> roomAreas;
+    uint64_t staticVersion;
+    size_t staticCellCount;
+    uint64_t tick; /**< Iteration of the last snapshot, markers expire by it. */
+    /**
+     * Objects of chunked worlds, only collected again for chunks that are or just were active,
+     * because objects in other chunks can't change.
+     */
+    std::vector<std::vector<SpriteInstance>> chunkSprites;
+    std::vector<bool> cachedChunks;
+    std::vector<bool> previouslyActiveChunks;
+    std::vector<const world::Cell*> chunkCells;
+
+    MarkerQueue markerQueue;
+    // only accessed by the simulator thread
+    std::unordered_map<uint64_t, ActiveMarker> namedMarkers;
+    std::vector<ActiveMarker> anonymousMarkers;
+    std::shared_ptr<const std::vector<SpriteInstance>> markerSprites;
+    uint64_t markerVersion;
+};
+} // namespace viz
+} // namespace srg
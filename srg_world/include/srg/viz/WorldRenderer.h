@@ -0,0 +1,82 @@
+#pragma once
+
+#include "srg/viz/SpriteType.h"
+#include "srg/viz/WorldSnapshot.h"
+
+#include <srg/world/RoomType.h>
+
+#include <SFML/Graphics.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+namespace srg
+{
+namespace viz
+{
+/**
+ * Renders world snapshots into a window or an offscreen texture. Has to be created and used by one thread,
+ * as it owns the texture of the sprites.
+ */
+class WorldRenderer
+{
+public:
+    /**
+     * @param lodPixelsPerCell Below this number of pixels per cell, rooms and aggregated objects are rendered instead of sprites.
+     */
+    WorldRenderer(float lodPixelsPerCell);
+    ~WorldRenderer();
+
+    /**
+     * Renders the part of the snapshot visible in the view of the target, without clearing or displaying it.
+     * @param spriteSize Size of a cell in world coordinates of the view.
+     * @param pixelsPerCell Size of a cell on the screen.
+     */
+    void render(sf::RenderTarget& target, const WorldSnapshot& snapshot, float spriteSize, float pixelsPerCell);
+
+    static sf::Color getColor(world::RoomType type);
+
+private:
+    void appendQuad(sf::VertexArray& vertices, const SpriteInstance& sprite);
+    void appendQuad(sf::VertexArray& vertices, const RoomArea& area);
+    sf::FloatRect calculateVisibleCells(const sf::RenderTarget& target);
+    void buildStaticLayer(const WorldSnapshot& snapshot);
+    void buildDynamicLayer(const WorldSnapshot& snapshot, const sf::FloatRect& visibleCells);
+    void buildAggregatedLayer(const WorldSnapshot& snapshot, const sf::FloatRect& visibleCells);
+    void buildMarkerLayer(const WorldSnapshot& snapshot);
+
+    uint32_t textureSize = 60;
+    float spriteSize = 0;
+    float lodPixelsPerCell;
+
+    sf::Texture* texture;
+    sf::IntRect textureRects[static_cast<int>(SpriteType::Last)];
+
+    /**
+     * Floor and walls in chunks of chunkSize x chunkSize cells, only rebuilt if the sprite size or the number
+     * of cells changed. Only the chunks intersecting the view are drawn. Visible objects and markers are
+     * collected into the dynamic layer every frame.
+     */
+    static const uint32_t chunkSize = 32;
+    std::vector<sf::VertexArray> staticChunks;
+    uint32_t chunksX = 0;
+    uint32_t chunksY = 0;
+    sf::VertexArray dynamicLayer;
+    /**
+     * Level of detail when zoomed out: one colored rectangle per room area and one sprite per
+     * lodBlockSize x lodBlockSize cells containing objects, scaled by their number.
+     */
+    static const uint32_t lodBlockSize = 8;
+    sf::VertexArray roomLayer;
+    std::unordered_map<uint64_t, std::pair<SpriteType, uint32_t>> aggregatedObjects;
+    float staticLayerSpriteSize = 0;
+    uint64_t staticLayerVersion = 0;
+    /**
+     * Markers are drawn with one call and only rebuilt if they or the sprite size changed.
+     */
+    sf::VertexArray markerLayer;
+    float markerLayerSpriteSize = 0;
+    uint64_t markerLayerVersion = 0;
+};
+} // namespace viz
+} // namespace srg
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "srg/viz/SpriteType.h"
+
+#include <srg/world/RoomType.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace srg
+{
+namespace viz
+{
+/**
+ * A sprite to render, position and size are given in cells.
+ */
+struct SpriteInstance
+{
+    SpriteInstance(SpriteType type, float x, float y, float size = 1.0f)
+            : type(type)
+            , x(x)
+            , y(y)
+            , size(size)
+    {
+    }
+
+    SpriteType type;
+    float x;
+    float y;
+    float size;
+};
+
+/**
+ * Rectangle of cells belonging to the same room, rendered instead of single cells when zoomed out.
+ */
+struct RoomArea
+{
+    RoomArea(world::RoomType type, float x, float y, float width, float height)
+            : type(type)
+            , x(x)
+            , y(y)
+            , width(width)
+            , height(height)
+    {
+    }
+
+    world::RoomType type;
+    float x;
+    float y;
+    float width;
+    float height;
+};
+
+/**
+ * Load of the simulator at the time of a snapshot, counters are totals since the start.
+ */
+struct SimulatorStats
+{
+    SimulatorStats()
+            : time(0)
+            , tickTime(0)
+            , overruns(0)
+            , commands(0)
+            , perceptionMessages(0)
+            , perceptionBytes(0)
+            , agents(0)
+            , activeChunks(0)
+            , residentChunks(0)
+            , worldLockWait(0)
+    {
+    }
+
+    std::chrono::steady_clock::duration time; /**< When the snapshot was built. */
+    std::chrono::steady_clock::duration tickTime; /**< Duration of the last complete iteration. */
+    uint64_t overruns;
+    uint64_t commands;
+    uint64_t perceptionMessages;
+    uint64_t perceptionBytes;
+    uint32_t agents;
+    uint32_t activeChunks; /**< 0 if the world is not chunked. */
+    uint32_t residentChunks;
+    std::chrono::steady_clock::duration worldLockWait; /**< Waiting for the world lock while building the snapshot. */
+};
+
+/**
+ * Everything the GUI thread needs to render one frame, published by the simulator thread.
+ */
+struct WorldSnapshot
+{
+    WorldSnapshot()
+            : sizeX(0)
+            , sizeY(0)
+            , tick(0)
+            , staticVersion(0)
+            , markerVersion(0)
+    {
+    }
+
+    uint32_t sizeX;
+    uint32_t sizeY;
+    uint64_t tick;
+    /**
+     * Floor and walls, shared between snapshots and only replaced if the grid changed.
+     */
+    std::shared_ptr<const std::vector<SpriteInstance>> staticSprites;
+    /**
+     * Rooms decomposed into rectangles, shared and replaced together with the static sprites.
+     */
+    std::shared_ptr<const std::vector<RoomArea>> roomAreas;
+    uint64_t staticVersion;
+    /**
+     * Objects and carried objects.
+     */
+    std::vector<SpriteInstance> dynamicSprites;
+    /**
+     * Debug markers, shared between snapshots and only replaced if markers were added, removed or expired.
+     */
+    std::shared_ptr<const std::vector<SpriteInstance>> markerSprites;
+    uint64_t markerVersion;
+    SimulatorStats stats;
+};
+} // namespace viz
+} // namespace srg
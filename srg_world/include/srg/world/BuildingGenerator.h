@@ -0,0 +1,109 @@
+#pragma once
+
+#include "srg/world/MapFile.h"
+#include "srg/world/RoomType.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace srg
+{
+namespace world
+{
+/**
+ * Layout of a generated office building: wings stacked on top of each other, connected by a
+ * vertical corridor on the left. Each wing has a horizontal corridor with a row of rooms above and below.
+ */
+struct BuildingParameters
+{
+    BuildingParameters()
+            : seed(1)
+            , wings(2)
+            , roomsPerRow(10)
+            , roomWidth(6)
+            , roomDepth(5)
+            , corridorWidth(2)
+            , cups(50)
+            , openDoorPercentage(70)
+    {
+    }
+
+    uint32_t seed;
+    uint32_t wings;
+    uint32_t roomsPerRow;
+    uint32_t roomWidth; /**< Inner width of a room in cells, without walls. */
+    uint32_t roomDepth; /**< Inner depth of a room in cells, without walls. */
+    uint32_t corridorWidth;
+    uint32_t cups;
+    uint32_t openDoorPercentage;
+};
+
+/**
+ * Generates office buildings for scale tests. The same parameters always give the same building,
+ * independent of the standard library, because only the raw output of std::mt19937 is used.
+ */
+class BuildingGenerator
+{
+public:
+    BuildingGenerator(const BuildingParameters& parameters);
+
+    /**
+     * Lays out the building, returns false if it would exceed the limits of the map format.
+     */
+    bool generate();
+    /**
+     * Writes the generated building in the binary map format loaded by srg::World.
+     */
+    bool writeMap(const std::string& mapFile) const;
+    /**
+     * Writes the doors and cups as "Objects" configuration, as read by the simulator from Objects.conf.
+     */
+    bool writeObjects(const std::string& objectsFile) const;
+    /**
+     * Writes the doors and cups as scenario file, see srg::world::Scenario.
+     */
+    bool writeScenario(const std::string& scenarioFile) const;
+
+    uint32_t getSizeX() const;
+    uint32_t getSizeY() const;
+    uint32_t getRoomCount() const;
+    uint32_t getDoorCount() const;
+    uint32_t getCupCount() const;
+
+    static const uint32_t firstRoomID = 1000000;
+    static const uint32_t firstObjectID = 2000000;
+
+private:
+    struct PlacedObject
+    {
+        std::string type;
+        uint32_t x;
+        uint32_t y;
+        bool open;
+    };
+
+    uint16_t addRoom(const std::string& name, RoomType type);
+    void fill(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint16_t room);
+    void addOfficeRoom(uint32_t x, uint32_t y, uint32_t doorX, uint32_t doorY);
+    void placeCups();
+    RoomType randomRoomType();
+    /**
+     * Uniform number in [0, bound).
+     */
+    uint32_t random(uint32_t bound);
+
+    BuildingParameters parameters;
+    std::mt19937 rng;
+
+    uint32_t sizeX;
+    uint32_t sizeY;
+    std::vector<MapFile::RoomRecord> rooms;
+    std::string names;
+    std::vector<MapFile::CellRecord> cells;
+    std::vector<PlacedObject> objects;
+    uint32_t doorCount;
+};
+} // namespace world
+} // namespace srg
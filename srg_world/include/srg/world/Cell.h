@@ -24,6 +24,7 @@ class Cell : public ObjectSet
 public:
     RoomType getType() const;
     bool isBlocked() const;
+    void markChanged() override;
 
     bool operator<(std::shared_ptr<const Cell> other);
     bool operator==(std::shared_ptr<const Cell> other);
@@ -42,6 +43,9 @@ public:
 
 private:
     Cell(uint32_t x, uint32_t y);
+
+    bool changed;
+    std::vector<Cell*>* changedCells; /**< Change log of the world, the cell adds itself once until the log is taken. */
 };
 
 bool operator==(std::shared_ptr<const Cell> first, std::shared_ptr<const Cell> second);
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "srg/world/ObjectState.h"
+#include "srg/world/ObjectType.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace srg
+{
+namespace world
+{
+/**
+ * Raw bytes of an essentials::Identifier, independent of the IDManager that created it.
+ */
+struct CheckpointID
+{
+    uint8_t type;
+    std::vector<uint8_t> bytes;
+};
+
+struct CheckpointObject
+{
+    enum class Container : uint8_t
+    {
+        None,
+        Cell,
+        Object
+    };
+
+    CheckpointID id;
+    ObjectType type;
+    ObjectState state;
+    Container container;
+    int32_t x; /**< Coordinate of the containing cell. */
+    int32_t y;
+    CheckpointID parent; /**< ID of the containing object, e.g., the agent carrying a cup. */
+};
+
+/**
+ * Dynamic state of a world: objects, their containers and states, agents, the random engine of the
+ * world and the iteration of the simulator. The static map is not part of it.
+ *
+ * Binary layout: magic, version, tick, sizeX, sizeY, random engine state, object count, objects.
+ */
+struct Checkpoint
+{
+    static const uint32_t magic = 0x43475253; // "SRGC"
+    static const uint32_t version = 1;
+
+    Checkpoint();
+
+    /**
+     * Writes to a temporary file and renames it, so a crash never leaves a partial checkpoint.
+     */
+    bool write(const std::string& checkpointFile) const;
+    bool read(const std::string& checkpointFile);
+
+    uint64_t tick;
+    uint32_t sizeX;
+    uint32_t sizeY;
+    std::string randomState; /**< Text representation of the std::mt19937 of the world. */
+    std::vector<CheckpointObject> objects;
+};
+} // namespace world
+} // namespace srg
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "srg/world/RoomType.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace srg
+{
+namespace world
+{
+/**
+ * Compiled map, memory-mapped read-only, so processes loading the same map share its pages.
+ *
+ * Layout: Header, RoomRecord[roomCount], names of the rooms, CellRecord[sizeX * sizeY] (column major, x * sizeY + y).
+ */
+class MapFile
+{
+public:
+    static const uint32_t magic = 0x4d475253; // "SRGM"
+    static const uint32_t version = 1;
+    static const uint16_t noRoom = 0xFFFF;
+
+    enum CellFlags : uint8_t
+    {
+        Passable = 1 << 0,
+        LeftNeighbour = 1 << 1,
+        UpNeighbour = 1 << 2,
+        RightNeighbour = 1 << 3,
+        DownNeighbour = 1 << 4
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceHash; /**< Hash of the TMX file this map was compiled from. */
+        uint32_t sizeX;
+        uint32_t sizeY;
+        uint32_t roomCount;
+        uint32_t cellCount;
+        uint64_t roomsOffset;
+        uint64_t namesOffset;
+        uint64_t cellsOffset;
+    };
+
+    struct RoomRecord
+    {
+        uint32_t id;
+        uint32_t type; /**< RoomType */
+        uint32_t nameOffset; /**< Relative to namesOffset. */
+        uint32_t nameLength;
+    };
+
+    struct CellRecord
+    {
+        uint16_t room; /**< Index into the room table, noRoom if there is no cell. */
+        uint8_t flags; /**< CellFlags */
+        uint8_t type;  /**< RoomType of the room, for readers that skip the room table. */
+    };
+
+    MapFile();
+    ~MapFile();
+
+    /**
+     * Maps the compiled map file, returns false if it is missing or invalid.
+     */
+    bool open(const std::string& mapFile);
+    void close();
+    bool isOpen() const;
+
+    const Header& getHeader() const;
+    const RoomRecord& getRoom(uint32_t index) const;
+    std::string getRoomName(uint32_t index) const;
+    /**
+     * @return The cell record, its room is noRoom if there is no cell at (x, y).
+     */
+    const CellRecord& getCell(uint32_t x, uint32_t y) const;
+
+    /**
+     * Parses the TMX file and writes the compiled map, returns false on errors.
+     */
+    static bool compile(const std::string& tmxFile, const std::string& mapFile);
+    /**
+     * Writes a map, the names of the rooms are concatenated in names. Only the room of the cells
+     * has to be set, their type and flags are derived from the rooms and neighbours.
+     */
+    static bool write(const std::string& mapFile, uint64_t sourceHash, uint32_t sizeX, uint32_t sizeY, const std::vector<RoomRecord>& rooms,
+            const std::string& names, std::vector<CellRecord>& cells);
+    /**
+     * Returns a compiled map for the TMX file from the cache in ~/.grid_sim/maps, compiling it if the
+     * content hash of the TMX file changed. Returns an empty string, if the cache is not writable.
+     */
+    static std::string findOrCompile(const std::string& tmxFile);
+    static uint64_t hashFile(const std::string& file);
+
+private:
+    void* data;
+    size_t size;
+};
+} // namespace world
+} // namespace srg
@@ -35,6 +35,7 @@ public:
     void deleteParentContainer();
 
     bool canBePickedUp(essentials::IdentifierConstPtr agentID) const;
+    void markChanged() override;
 
     friend std::ostream& operator<<(std::ostream& os, const Object& obj);
 protected:
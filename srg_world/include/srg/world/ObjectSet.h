@@ -24,6 +24,10 @@ public:
     virtual void update(std::vector<std::shared_ptr<world::Object>> objects);
     virtual bool contains(std::shared_ptr<const world::Object> object) const;
     virtual bool contains(essentials::IdentifierConstPtr objectID) const;
+    /**
+     * Called whenever the contained objects change, propagated up to the containing cell.
+     */
+    virtual void markChanged();
     friend ::srg::World;
     friend std::ostream& operator<<(std::ostream& os, const ObjectSet& objectSet);
 
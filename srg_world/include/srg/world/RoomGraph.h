@@ -0,0 +1,93 @@
+#pragma once
+
+#include "srg/world/Coordinate.h"
+
+#include <essentials/IdentifierConstPtr.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace srg
+{
+namespace world
+{
+class Cell;
+class Room;
+
+/**
+ * Abstract graph of the world for long-range planning: rooms are the nodes, portals between them the edges.
+ * Portals are doors and, for rooms bordering each other without a door, one open passage per pair of rooms.
+ * Each room stores the traversal costs between its portals, so a route only has to be searched over the
+ * portals (HPA*-style) and refined into cells segment by segment.
+ *
+ * Opening and closing doors only flips the state of their portal. Building the graph and changing doors is not
+ * thread-safe, a graph that is not changed anymore (e.g., published as shared_ptr<const RoomGraph>) can be
+ * searched by any number of threads at the same time.
+ */
+class RoomGraph
+{
+public:
+    RoomGraph();
+
+    /**
+     * Rebuilds rooms, portals and the traversal costs within each room from the given (resident) cells.
+     */
+    void build(const std::map<Coordinate, std::shared_ptr<Cell>>& grid, uint32_t sizeX, uint32_t sizeY);
+    /**
+     * @return False if the door is not part of the graph.
+     */
+    bool setDoorOpen(essentials::IdentifierConstPtr doorID, bool open);
+    /**
+     * Connects start and goal to the portals of their rooms and searches the cheapest route through open portals.
+     * @param waypoints Filled with the cells to pass in order, starting with from and ending with to.
+     * @param cost Number of moves along the route.
+     * @param expansions Number of expanded portals.
+     * @return False if there is no route or start or goal are not part of a room.
+     */
+    bool findRoute(const Coordinate& from, const Coordinate& to, std::vector<Coordinate>& waypoints, uint32_t& cost, uint32_t& expansions) const;
+
+    uint32_t getRoomCount() const;
+    uint32_t getPortalCount() const;
+    uint32_t getDoorCount() const;
+
+    static const uint32_t unreachable = 0xFFFFFFFF;
+
+private:
+    struct Portal
+    {
+        essentials::IdentifierConstPtr doorID; /**< nullptr for passages, which are always open. */
+        uint32_t cell;
+        std::vector<uint32_t> rooms;
+        bool open;
+    };
+
+    struct RoomNode
+    {
+        Room* room;
+        std::vector<uint32_t> portals;
+        std::vector<uint32_t> costs; /**< Moves from portal i to portal j of this room at costs[i * portals.size() + j]. */
+    };
+
+    /**
+     * Breadth-first search from the cell through the cells of the room, door cells are only entered, never left.
+     * @param portalCosts Moves to each portal of the room, unreachable if it can't be reached within the room.
+     */
+    void traverse(uint32_t roomNode, uint32_t startCell, std::vector<uint32_t>& portalCosts, uint32_t targetCell, uint32_t& targetCost) const;
+    uint32_t collectNeighbours(uint32_t cell, uint32_t (&neighbours)[4]) const;
+    int32_t findRoomPortal(uint32_t roomNode, uint32_t portal) const;
+    uint32_t distance(uint32_t cell, uint32_t otherCell) const;
+
+    uint32_t sizeX;
+    uint32_t sizeY;
+    std::vector<int32_t> cellRooms;   /**< Room node of each cell (x * sizeY + y), -1 for walls and missing cells. */
+    std::vector<int32_t> cellPortals; /**< Portal of each cell, -1 for none. */
+    std::vector<RoomNode> roomNodes;
+    std::vector<Portal> portals;
+    std::unordered_map<essentials::IdentifierConstPtr, uint32_t> doorPortals;
+    uint32_t doorCount;
+};
+} // namespace world
+} // namespace srg
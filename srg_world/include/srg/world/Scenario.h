@@ -0,0 +1,60 @@
+#pragma once
+
+#include "srg/world/ObjectState.h"
+#include "srg/world/ObjectType.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace srg
+{
+namespace world
+{
+struct ScenarioObject
+{
+    int32_t id;
+    ObjectType type;
+    ObjectState state;
+    int32_t x;
+    int32_t y;
+};
+
+/**
+ * Objects to place into a world, read from a CSV file with one object per line:
+ *
+ *   # id,type,x,y,state
+ *   2000000,door,5,6,open
+ *   2000001,cup_red,10,12
+ *
+ * Types are door, cup_red, cup_blue and cup_yellow, the state (open, closed) is only required for doors.
+ * Empty lines and lines starting with '#' are skipped.
+ */
+class Scenario
+{
+public:
+    Scenario();
+
+    /**
+     * Parses the file in one pass, invalid lines and duplicate IDs are reported and skipped.
+     * @return False if the file can't be read.
+     */
+    bool load(const std::string& scenarioFile);
+    bool write(const std::string& scenarioFile) const;
+
+    void addObject(const ScenarioObject& object);
+    const std::vector<ScenarioObject>& getObjects() const;
+    uint32_t getErrorCount() const;
+
+    static bool parseType(const char* type, ObjectType& objectType);
+    static const char* toString(ObjectType type);
+
+private:
+    bool parseLine(char* line, ScenarioObject& object) const;
+    void reportError(uint32_t lineNumber, const std::string& message);
+
+    std::vector<ScenarioObject> objects;
+    uint32_t errorCount;
+};
+} // namespace world
+} // namespace srg
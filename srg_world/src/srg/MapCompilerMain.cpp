@@ -0,0 +1,28 @@
+#include "srg/world/MapFile.h"
+
+#include <iostream>
+#include <string>
+
+/**
+ * Compiles a TMX map into the binary map format loaded by srg::World.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <map.tmx> <map.srgmap>" << std::endl;
+        return 1;
+    }
+
+    if (!srg::world::MapFile::compile(argv[1], argv[2])) {
+        return 1;
+    }
+
+    srg::world::MapFile map;
+    if (!map.open(argv[2])) {
+        return 1;
+    }
+    const srg::world::MapFile::Header& header = map.getHeader();
+    std::cout << "[MapCompiler] Compiled " << argv[1] << ": " << header.sizeX << "x" << header.sizeY << " cells, " << header.cellCount << " used, "
+              << header.roomCount << " rooms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "srg/world/BuildingGenerator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+/**
+ * Generates an office building in the binary map format loaded by srg::World,
+ * together with the doors and cups for the Objects.conf of the simulator.
+ */
+int main(int argc, char* argv[])
+{
+    srg::world::BuildingParameters parameters;
+    std::string mapFile = "Building.srgmap";
+    std::string objectsFile = "Objects.conf";
+    std::string scenarioFile;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        uint32_t value = std::strtoul(argv[i + 1], nullptr, 10);
+        if (strcmp(argv[i], "--seed") == 0) {
+            parameters.seed = value;
+        } else if (strcmp(argv[i], "--wings") == 0) {
+            parameters.wings = value;
+        } else if (strcmp(argv[i], "--rooms") == 0) {
+            parameters.roomsPerRow = value;
+        } else if (strcmp(argv[i], "--room-width") == 0) {
+            parameters.roomWidth = value;
+        } else if (strcmp(argv[i], "--room-depth") == 0) {
+            parameters.roomDepth = value;
+        } else if (strcmp(argv[i], "--corridor-width") == 0) {
+            parameters.corridorWidth = value;
+        } else if (strcmp(argv[i], "--cups") == 0) {
+            parameters.cups = value;
+        } else if (strcmp(argv[i], "--open-doors") == 0) {
+            parameters.openDoorPercentage = value;
+        } else if (strcmp(argv[i], "--map") == 0) {
+            mapFile = argv[i + 1];
+        } else if (strcmp(argv[i], "--objects") == 0) {
+            objectsFile = argv[i + 1];
+        } else if (strcmp(argv[i], "--scenario") == 0) {
+            scenarioFile = argv[i + 1];
+        } else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if (argc % 2 == 0) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--seed N] [--wings N] [--rooms <rooms per row>] [--room-width N] [--room-depth N] [--corridor-width N] [--cups N]"
+                     " [--open-doors <percentage>] [--map <map.srgmap>] [--objects <Objects.conf>] [--scenario <objects.csv>]"
+                  << std::endl;
+        return 1;
+    }
+
+    srg::world::BuildingGenerator generator(parameters);
+    if (!generator.generate() || !generator.writeMap(mapFile) || !generator.writeObjects(objectsFile)) {
+        return 1;
+    }
+    if (!scenarioFile.empty() && !generator.writeScenario(scenarioFile)) {
+        return 1;
+    }
+    std::cout << "[MapGenerator] Generated " << mapFile << ": " << generator.getSizeX() << "x" << generator.getSizeY() << " cells, "
+              << generator.getRoomCount() << " rooms, " << generator.getDoorCount() << " doors, " << generator.getCupCount() << " cups in " << objectsFile
+              << std::endl;
+    return 0;
+}
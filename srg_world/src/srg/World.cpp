@@ -2,9 +2,12 @@
 
 #include "srg/world/Agent.h"
 #include "srg/world/Cell.h"
+#include "srg/world/Checkpoint.h"
 #include "srg/world/Door.h"
+#include "srg/world/MapFile.h"
 #include "srg/world/Object.h"
 #include "srg/world/Room.h"
+#include "srg/world/Scenario.h"
 
 #include <essentials/IDManager.h>
 #include <essentials/SystemConfig.h>
@@ -12,7 +15,10 @@
 #include <Tmx.h>
 #include <essentials/FileSystem.h>
 
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <unordered_set>
 
 namespace srg
 {
@@ -21,14 +27,101 @@ World::World(essentials::IDManager& idManager)
 {
 }
 
-World::World(std::string tmxMapFile, essentials::IDManager& idManager)
+World::World(std::string mapFile, essentials::IDManager& idManager, uint32_t chunkSize)
         : sizeX(0)
         , sizeY(0)
+        , map(nullptr)
+        , chunkSize(chunkSize)
+        , chunksX(0)
+        , chunksY(0)
+        , residentChunkCount(0)
+        , topologyVersion(0)
 {
-    std::cout << "[World] Loading '" << tmxMapFile << "' world file!" << std::endl;
-    Tmx::Map* map = new Tmx::Map();
-    map->ParseFile(tmxMapFile);
-    for (auto layer : map->GetTileLayers()) {
+    std::cout << "[World] Loading '" << mapFile << "' world file!" << std::endl;
+    std::string compiledMapFile = mapFile;
+    if (mapFile.size() < 7 || mapFile.compare(mapFile.size() - 7, 7, ".srgmap") != 0) {
+        compiledMapFile = world::MapFile::findOrCompile(mapFile);
+    }
+    // only compiled maps can be materialized chunk by chunk
+    this->map = new world::MapFile();
+    bool opened = !compiledMapFile.empty() && this->map->open(compiledMapFile);
+    bool lazy = opened && chunkSize > 0;
+    if (opened) {
+        this->loadMap(*this->map, idManager, lazy);
+    } else {
+        std::cerr << "[World] No compiled map for '" << mapFile << "', parsing it directly!" << std::endl;
+        this->loadTmx(mapFile, idManager);
+    }
+    if (!lazy) {
+        delete this->map;
+        this->map = nullptr;
+    }
+    this->initChunks(lazy);
+}
+
+/**
+ * Creates the rooms and cells from the dense cell array, neighbours are linked
+ * without lookups and the cells are appended to the ordered grid.
+ * If lazy, only the rooms are created and the cells follow chunk by chunk.
+ */
+void World::loadMap(const world::MapFile& map, essentials::IDManager& idManager, bool lazy)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    const world::MapFile::Header& header = map.getHeader();
+    std::vector<world::Room*> mapRooms;
+    mapRooms.reserve(header.roomCount);
+    for (uint32_t i = 0; i < header.roomCount; i++) {
+        const world::MapFile::RoomRecord& record = map.getRoom(i);
+        uint32_t roomIDInt = record.id;
+        world::Room* room = this->addRoom(map.getRoomName(i), idManager.getID(roomIDInt));
+        room->type = static_cast<world::RoomType>(static_cast<int32_t>(record.type));
+        mapRooms.push_back(room);
+    }
+    this->sizeX = header.sizeX;
+    this->sizeY = header.sizeY;
+    if (lazy) {
+        std::cout << "[World] Added " << mapRooms.size() << " rooms, their cells are created on demand" << std::endl;
+        this->mapRooms = mapRooms;
+        return;
+    }
+
+    std::vector<std::shared_ptr<world::Cell>> previousColumn(header.sizeY);
+    std::vector<std::shared_ptr<world::Cell>> column(header.sizeY);
+    for (uint32_t x = 0; x < header.sizeX; x++) {
+        for (uint32_t y = 0; y < header.sizeY; y++) {
+            const world::MapFile::CellRecord& record = map.getCell(x, y);
+            if (record.room == world::MapFile::noRoom || record.room >= mapRooms.size()) {
+                column[y] = nullptr;
+                continue;
+            }
+            std::shared_ptr<world::Cell> cell = std::shared_ptr<world::Cell>(new world::Cell(x, y));
+            cell->changedCells = &this->changedCells;
+            // ordered by x, then y
+            this->cellGrid.emplace_hint(this->cellGrid.end(), cell->coordinate, cell);
+            if ((record.flags & world::MapFile::UpNeighbour) && column[y - 1]) {
+                cell->up = column[y - 1];
+                column[y - 1]->down = cell;
+            }
+            if ((record.flags & world::MapFile::LeftNeighbour) && previousColumn[y]) {
+                cell->left = previousColumn[y];
+                previousColumn[y]->right = cell;
+            }
+            mapRooms[record.room]->addCell(cell);
+            column[y] = cell;
+        }
+        std::swap(previousColumn, column);
+    }
+
+    for (world::Room* room : mapRooms) {
+        std::cout << "[World] Added " << *room << std::endl;
+    }
+}
+
+void World::loadTmx(std::string tmxMapFile, essentials::IDManager& idManager)
+{
+    Tmx::Map map;
+    map.ParseFile(tmxMapFile);
+    for (auto layer : map.GetTileLayers()) {
         // create room
         std::string roomName = layer->GetName();
         uint32_t roomIDInt = layer->GetProperties().GetIntProperty("ID");
@@ -57,6 +150,116 @@ World::~World()
     for (auto& room : rooms) {
         delete room.second;
     }
+    delete this->map;
+}
+
+void World::initChunks(bool lazy)
+{
+    if (this->chunkSize == 0) {
+        return;
+    }
+    this->chunksX = (this->sizeX + this->chunkSize - 1) / this->chunkSize;
+    this->chunksY = (this->sizeY + this->chunkSize - 1) / this->chunkSize;
+    this->residentChunks.assign(this->chunksX * this->chunksY, !lazy);
+    this->activeChunks.assign(this->chunksX * this->chunksY, false);
+    this->residentChunkCount = lazy ? 0 : this->chunksX * this->chunksY;
+    std::cout << "[World] Split into " << this->chunksX << "x" << this->chunksY << " chunks of " << this->chunkSize << "x" << this->chunkSize << " cells"
+              << std::endl;
+}
+
+/**
+ * Creates the cells of the chunk from the compiled map, links them to the cells of resident neighbour
+ * chunks and places the objects waiting for the chunk.
+ */
+void World::materializeChunk(uint32_t chunk)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    if (this->residentChunks[chunk]) {
+        return;
+    }
+    this->residentChunks[chunk] = true;
+    this->residentChunkCount++;
+    this->topologyVersion++;
+
+    uint32_t startX = (chunk / this->chunksY) * this->chunkSize;
+    uint32_t startY = (chunk % this->chunksY) * this->chunkSize;
+    uint32_t endX = std::min(startX + this->chunkSize, this->sizeX);
+    uint32_t endY = std::min(startY + this->chunkSize, this->sizeY);
+    for (uint32_t x = startX; x < endX; x++) {
+        for (uint32_t y = startY; y < endY; y++) {
+            const world::MapFile::CellRecord& record = this->map->getCell(x, y);
+            if (record.room == world::MapFile::noRoom || record.room >= this->mapRooms.size()) {
+                continue;
+            }
+            std::shared_ptr<world::Cell> cell = std::shared_ptr<world::Cell>(new world::Cell(x, y));
+            cell->changedCells = &this->changedCells;
+            this->cellGrid.emplace(cell->coordinate, cell);
+            if (record.flags & world::MapFile::LeftNeighbour) {
+                auto it = this->cellGrid.find(world::Coordinate(x - 1, y));
+                if (it != this->cellGrid.end()) {
+                    cell->left = it->second;
+                    it->second->right = cell;
+                }
+            }
+            if (record.flags & world::MapFile::UpNeighbour) {
+                auto it = this->cellGrid.find(world::Coordinate(x, y - 1));
+                if (it != this->cellGrid.end()) {
+                    cell->up = it->second;
+                    it->second->down = cell;
+                }
+            }
+            if ((record.flags & world::MapFile::RightNeighbour) && x + 1 == endX) {
+                auto it = this->cellGrid.find(world::Coordinate(x + 1, y));
+                if (it != this->cellGrid.end()) {
+                    cell->right = it->second;
+                    it->second->left = cell;
+                }
+            }
+            if ((record.flags & world::MapFile::DownNeighbour) && y + 1 == endY) {
+                auto it = this->cellGrid.find(world::Coordinate(x, y + 1));
+                if (it != this->cellGrid.end()) {
+                    cell->down = it->second;
+                    it->second->up = cell;
+                }
+            }
+            this->mapRooms[record.room]->addCell(cell);
+        }
+    }
+
+    auto pending = this->pendingObjects.find(chunk);
+    if (pending != this->pendingObjects.end()) {
+        std::vector<std::pair<std::shared_ptr<world::Object>, world::Coordinate>> objects = std::move(pending->second);
+        this->pendingObjects.erase(pending);
+        for (auto& objectCoordinatePair : objects) {
+            if (objectCoordinatePair.first->getParentContainer()) {
+                // placed elsewhere in the meantime
+                continue;
+            }
+            if (!this->placeObject(objectCoordinatePair.first, objectCoordinatePair.second)) {
+                std::cerr << "[World] Placement of " << objectCoordinatePair.first->getType() << " to " << objectCoordinatePair.second << " not allowed!"
+                          << std::endl;
+            }
+        }
+    }
+}
+
+/**
+ * Looks up a cell and materializes its chunk first, if necessary. Materializing doesn't
+ * change the world as seen from the outside, so this is fine for const lookups.
+ */
+std::shared_ptr<world::Cell> World::findCell(const world::Coordinate& coordinate) const
+{
+    if (this->map) {
+        int64_t chunk = this->getChunkIndex(coordinate);
+        if (chunk >= 0 && !this->residentChunks[chunk]) {
+            const_cast<World*>(this)->materializeChunk(chunk);
+        }
+    }
+    auto cellEntry = this->cellGrid.find(coordinate);
+    if (cellEntry != this->cellGrid.end()) {
+        return cellEntry->second;
+    }
+    return nullptr;
 }
 
 world::Room* World::addRoom(std::string name, essentials::IdentifierConstPtr id)
@@ -71,12 +274,14 @@ std::shared_ptr<world::Cell> World::addCell(uint32_t x, uint32_t y, world::Room*
 {
     std::lock_guard<std::recursive_mutex> guard(dataMutex);
     world::Coordinate cellCoordinate = world::Coordinate(x, y);
+    this->topologyVersion++;
 
     if (this->cellGrid.find(cellCoordinate) != this->cellGrid.end()) {
         return this->cellGrid.at(cellCoordinate);
     }
 
     std::shared_ptr<world::Cell> cell = std::shared_ptr<world::Cell>(new world::Cell(x, y));
+    cell->changedCells = &this->changedCells;
     this->cellGrid.emplace(cell->coordinate, cell);
 
     // Left
@@ -119,10 +324,13 @@ std::shared_ptr<world::Cell> World::addCell(uint32_t x, uint32_t y, world::Room*
 std::shared_ptr<const world::Cell> World::getCell(const world::Coordinate& coordinate) const
 {
     std::lock_guard<std::recursive_mutex> guard(dataMutex);
-    if (this->cellGrid.find(coordinate) != this->cellGrid.end()) {
-        return this->cellGrid.at(coordinate);
-    }
-    return nullptr;
+    return this->findCell(coordinate);
+}
+
+std::shared_ptr<world::Cell> World::editCell(const world::Coordinate& coordinate)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    return this->findCell(coordinate);
 }
 
 std::vector<std::shared_ptr<const world::Object>> World::editObjects()
@@ -137,6 +345,11 @@ std::vector<std::shared_ptr<const world::Object>> World::editObjects()
 bool World::placeObject(std::shared_ptr<world::Object> object, world::Coordinate coordinate)
 {
     std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    if (this->isPlacementDeferred(coordinate)) {
+        // placed and checked when the chunk is materialized
+        this->pendingObjects[this->getChunkIndex(coordinate)].emplace_back(object, coordinate);
+        return true;
+    }
     auto cellIter = this->cellGrid.find(coordinate);
     if (cellIter == this->cellGrid.end()) {
         return false;
@@ -147,9 +360,50 @@ bool World::placeObject(std::shared_ptr<world::Object> object, world::Coordinate
     }
 
     object->setParentContainer(cellIter->second);
+    if (object->getType() == world::ObjectType::Door) {
+        this->topologyVersion++;
+    }
     return true;
 }
 
+/**
+ * Placements into chunks that are not resident yet are queued, materializing them just for checking the placement
+ * would defeat lazy loading.
+ */
+bool World::isPlacementDeferred(const world::Coordinate& coordinate) const
+{
+    int64_t chunk = this->getChunkIndex(coordinate);
+    return this->map && chunk >= 0 && !this->residentChunks[chunk];
+}
+
+uint32_t World::placeObjects(const std::vector<world::ScenarioObject>& scenarioObjects, essentials::IDManager& idManager, uint32_t& deferred)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    this->objects.reserve(this->objects.size() + scenarioObjects.size());
+    this->objectCache.reserve(this->objectCache.size() + scenarioObjects.size());
+    uint32_t placed = 0;
+    deferred = 0;
+    for (const world::ScenarioObject& scenarioObject : scenarioObjects) {
+        essentials::IdentifierConstPtr id = essentials::IdentifierConstPtr(idManager.getID<int32_t>(scenarioObject.id));
+        std::shared_ptr<world::Object> object = this->createOrUpdateObject(id, scenarioObject.type, scenarioObject.state);
+        if (object->getParentContainer()) {
+            continue;
+        }
+        world::Coordinate coordinate(scenarioObject.x, scenarioObject.y);
+        bool deferredPlacement = this->isPlacementDeferred(coordinate);
+        if (this->placeObject(object, coordinate)) {
+            if (deferredPlacement) {
+                deferred++;
+            } else {
+                placed++;
+            }
+        } else {
+            std::cout << "[World] Placement of " << scenarioObject.type << " to " << coordinate << " not allowed!" << std::endl;
+        }
+    }
+    return placed;
+}
+
 std::shared_ptr<const world::Object> World::getObject(world::ObjectType type) const
 {
     std::lock_guard<std::recursive_mutex> guard(dataMutex);
@@ -189,7 +443,7 @@ bool World::setAsKnownObject(essentials::IdentifierConstPtr id)
 {
     std::lock_guard<std::recursive_mutex> guard(dataMutex);
     auto objectEntry = this->objectCache.find(id);
-    if (objectEntry != this->objects.end()) {
+    if (objectEntry != this->objectCache.end()) {
         objects.emplace(objectEntry->second->getID(), objectEntry->second);
         return true;
     } else {
@@ -245,7 +499,6 @@ std::shared_ptr<world::Agent> World::spawnAgent(essentials::IdentifierConstPtr i
     }
 
     // search for cell with valid spawn coordinates
-    srand(time(NULL));
     std::shared_ptr<const world::Cell> cell = nullptr;
     int x = 72;
     int y = 20;
@@ -268,45 +521,55 @@ std::shared_ptr<world::Agent> World::spawnAgent(essentials::IdentifierConstPtr i
 std::shared_ptr<world::Object> World::createOrUpdateObject(std::shared_ptr<world::Object> tmpObject)
 {
     std::lock_guard<std::recursive_mutex> guard(dataMutex);
-    setAsKnownObject(tmpObject->getID());
-    std::shared_ptr<world::Object> object = editObject(tmpObject->getID());
+    std::shared_ptr<world::Object> object = this->createOrUpdateObject(tmpObject->getID(), tmpObject->getType(), tmpObject->getState());
+
+    for (auto& childMsgObjectEntry : tmpObject->getObjects()) {
+        object->addObject(createOrUpdateObject(childMsgObjectEntry.second));
+    }
+
+    return object;
+}
+
+std::shared_ptr<world::Object> World::createOrUpdateObject(essentials::IdentifierConstPtr id, world::ObjectType type, world::ObjectState state)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    std::shared_ptr<world::Object> object = editObject(id);
+    if (!object && setAsKnownObject(id)) {
+        object = editObject(id);
+    }
     if (!object) {
-        switch (tmpObject->getType()) {
+        switch (type) {
         case world::ObjectType::Robot:
         case world::ObjectType::Human:
-            object = std::make_shared<world::Agent>(tmpObject->getID(), tmpObject->getType());
+            object = std::make_shared<world::Agent>(id, type);
             break;
         case world::ObjectType::Door:
-            object = std::make_shared<world::Door>(tmpObject->getID(), tmpObject->getState());
+            object = std::make_shared<world::Door>(id, state);
             break;
         default:
-            object = std::make_shared<world::Object>(tmpObject->getID(), tmpObject->getType(), tmpObject->getState());
+            object = std::make_shared<world::Object>(id, type, state);
         }
 //        std::cout << "[World] Created " << *object;
         this->objectCache.emplace(object->getID(), object);
         this->objects.emplace(object->getID(), object);
     }
 
-    object->setType(tmpObject->getType());
-    object->setState(tmpObject->getState());
-
-    for (auto& childMsgObjectEntry : tmpObject->getObjects()) {
-        object->addObject(createOrUpdateObject(childMsgObjectEntry.second));
-    }
-
+    object->setType(type);
+    object->setState(state);
     return object;
 }
 
 void World::updateCell(world::Coordinate coordinate, std::vector<std::shared_ptr<world::Object>> objects, int64_t time)
 {
     std::lock_guard<std::recursive_mutex> guard(dataMutex);
-    auto cellEntry = this->cellGrid.find(coordinate);
-    if (cellEntry == this->cellGrid.end()) {
+    std::shared_ptr<world::Cell> cell = this->findCell(coordinate);
+    if (!cell) {
         return;
     }
-    //    std::cout << "[World]" << *cellEntry->second << std::endl;
-    cellEntry->second->timeOfLastUpdate = time;
-    cellEntry->second->update(objects);
+    //    std::cout << "[World]" << *cell << std::endl;
+    cell->timeOfLastUpdate = time;
+    cell->update(objects);
+    this->topologyVersion++;
 }
 
 /**
@@ -352,22 +615,57 @@ void World::moveObject(essentials::IdentifierConstPtr id, world::Direction direc
 void World::displaceObject()
 {
     std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    if (this->chunkSize > 0) {
+        // only cups in active chunks are displaced, and only within active chunks
+        std::vector<std::shared_ptr<world::Object>> cups;
+        for (auto& objectEntry : this->objects) {
+            world::ObjectType type = objectEntry.second->getType();
+            if ((type == world::ObjectType::CupBlue || type == world::ObjectType::CupYellow || type == world::ObjectType::CupRed) &&
+                    objectEntry.second->canBePickedUp(nullptr)) {
+                int64_t chunk = this->getChunkIndex(objectEntry.second->getCoordinate());
+                if (chunk >= 0 && this->activeChunks[chunk]) {
+                    cups.push_back(objectEntry.second);
+                }
+            }
+        }
+        if (cups.empty() || this->activeChunkList.empty()) {
+            return;
+        }
+        this->placeObject(cups[this->random(cups.size())], this->getRandomActiveCoordinate());
+        return;
+    }
 
+    if (this->objects.empty()) {
+        return;
+    }
     std::unordered_map<essentials::IdentifierConstPtr, std::shared_ptr<world::Object>>::const_iterator objectIter;
     while (true) {
         objectIter = this->objects.begin();
-        std::advance(objectIter, rand() % this->objects.size());
+        std::advance(objectIter, this->random(this->objects.size()));
         if (objectIter->second->getType() == world::ObjectType::CupBlue || objectIter->second->getType() == world::ObjectType::CupYellow ||
                 objectIter->second->getType() == world::ObjectType::CupRed) {
             if (objectIter->second->canBePickedUp(nullptr)) { // not sure, whether nullptr is ok
                 world::Coordinate randomCoordinate = this->getRandomCoordinate();
-                this->placeObject(objectIter->second, randomCoordinate);
+                if (randomCoordinate.x >= 0) {
+                    this->placeObject(objectIter->second, randomCoordinate);
+                }
                 return;
             }
         }
     }
 }
 
+void World::takeChangedCells(std::vector<const world::Cell*>& cells)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    cells.clear();
+    for (world::Cell* cell : this->changedCells) {
+        cell->changed = false;
+        cells.push_back(cell);
+    }
+    this->changedCells.clear();
+}
+
 bool World::addAgent(std::shared_ptr<world::Agent> agent)
 {
     std::lock_guard<std::recursive_mutex> guard(dataMutex);
@@ -418,6 +716,12 @@ const std::vector<world::Room*> World::getRooms(world::RoomType type) const
     return rooms;
 }
 
+uint64_t World::getTopologyVersion() const
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    return this->topologyVersion;
+}
+
 // INTERNAL METHODS
 
 std::shared_ptr<world::Cell> World::getNeighbourCell(const world::Direction& direction, std::shared_ptr<world::Object> object)
@@ -456,7 +760,7 @@ bool World::isPlacementAllowed(std::shared_ptr<const world::Cell> cell, world::O
 srg::world::Coordinate World::getRandomCoordinate()
 {
     // statistic evaluation of room
-    int randRoomValue = rand() % 100;
+    int randRoomValue = this->random(100);
     std::vector<srg::world::Room*> rooms;
     if (randRoomValue < 30) {
         // kitchen
@@ -478,17 +782,258 @@ srg::world::Coordinate World::getRandomCoordinate()
         }
     }
 
+    if (rooms.empty()) {
+        std::cerr << "[World] No room to pick a random coordinate from!" << std::endl;
+        return srg::world::Coordinate(-1, -1);
+    }
+
     // random coordinate in a random room
-    randRoomValue = rand() % rooms.size();
+    randRoomValue = this->random(rooms.size());
     srg::world::Room* room = rooms[randRoomValue];
 
     auto& cells = room->getCells();
+    if (cells.empty()) {
+        std::cerr << "[World] Random room has no cells to pick a coordinate from!" << std::endl;
+        return srg::world::Coordinate(-1, -1);
+    }
     std::map<srg::world::Coordinate, std::shared_ptr<srg::world::Cell>>::const_iterator cellIter;
     cellIter = cells.begin();
-    std::advance(cellIter, rand() % cells.size());
+    std::advance(cellIter, this->random(cells.size()));
     return cellIter->first;
 }
 
+/**
+ * Random coordinate of a cell in an active chunk, for lack of room statistics within chunks.
+ */
+srg::world::Coordinate World::getRandomActiveCoordinate()
+{
+    for (int attempt = 0; attempt < 100; attempt++) {
+        uint32_t chunk = this->activeChunkList[this->random(this->activeChunkList.size())];
+        world::Coordinate coordinate((chunk / this->chunksY) * this->chunkSize + this->random(this->chunkSize),
+                (chunk % this->chunksY) * this->chunkSize + this->random(this->chunkSize));
+        auto cellEntry = this->cellGrid.find(coordinate);
+        if (cellEntry != this->cellGrid.end() && cellEntry->second->getType() != world::RoomType::Wall) {
+            return coordinate;
+        }
+    }
+    return world::Coordinate(-1, -1);
+}
+
+uint32_t World::getChunkSize() const
+{
+    return this->chunkSize;
+}
+
+uint32_t World::getChunkCount() const
+{
+    return this->chunksX * this->chunksY;
+}
+
+int64_t World::getChunkIndex(const world::Coordinate& coordinate) const
+{
+    if (this->chunkSize == 0 || coordinate.x < 0 || coordinate.y < 0 || uint32_t(coordinate.x) >= this->sizeX || uint32_t(coordinate.y) >= this->sizeY) {
+        return -1;
+    }
+    return int64_t(coordinate.x / this->chunkSize) * this->chunksY + coordinate.y / this->chunkSize;
+}
+
+bool World::isChunkActive(uint32_t chunk) const
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    return this->activeChunks[chunk];
+}
+
+bool World::isChunkResident(uint32_t chunk) const
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    return this->residentChunks[chunk];
+}
+
+uint32_t World::getActiveChunkCount() const
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    return this->activeChunkList.size();
+}
+
+uint32_t World::getResidentChunkCount() const
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    return this->residentChunkCount;
+}
+
+void World::updateActiveChunks(uint32_t range)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    if (this->chunkSize == 0) {
+        return;
+    }
+    for (uint32_t chunk : this->activeChunkList) {
+        this->activeChunks[chunk] = false;
+    }
+    this->activeChunkList.clear();
+    for (auto& agentEntry : this->agents) {
+        world::Coordinate coordinate = agentEntry.second->getCoordinate();
+        if (coordinate.x < 0 || coordinate.y < 0) {
+            continue;
+        }
+        uint32_t fromX = uint32_t(std::max<int64_t>(0, int64_t(coordinate.x) - range)) / this->chunkSize;
+        uint32_t fromY = uint32_t(std::max<int64_t>(0, int64_t(coordinate.y) - range)) / this->chunkSize;
+        uint32_t toX = std::min<uint32_t>((uint32_t(coordinate.x) + range) / this->chunkSize, this->chunksX - 1);
+        uint32_t toY = std::min<uint32_t>((uint32_t(coordinate.y) + range) / this->chunkSize, this->chunksY - 1);
+        for (uint32_t chunkX = fromX; chunkX <= toX; chunkX++) {
+            for (uint32_t chunkY = fromY; chunkY <= toY; chunkY++) {
+                uint32_t chunk = chunkX * this->chunksY + chunkY;
+                if (this->activeChunks[chunk]) {
+                    continue;
+                }
+                if (this->map) {
+                    this->materializeChunk(chunk);
+                }
+                this->activeChunks[chunk] = true;
+                this->activeChunkList.push_back(chunk);
+            }
+        }
+    }
+}
+
+void World::collectChunkCells(uint32_t chunk, std::vector<const world::Cell*>& cells) const
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    cells.clear();
+    int32_t startX = (chunk / this->chunksY) * this->chunkSize;
+    int32_t startY = (chunk % this->chunksY) * this->chunkSize;
+    for (int32_t x = startX; x < startX + int32_t(this->chunkSize); x++) {
+        for (auto it = this->cellGrid.lower_bound(world::Coordinate(x, startY));
+                it != this->cellGrid.end() && it->first.x == x && it->first.y < startY + int32_t(this->chunkSize); ++it) {
+            cells.push_back(it->second.get());
+        }
+    }
+}
+
+uint32_t World::random(uint32_t bound)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    if (bound == 0) {
+        return 0;
+    }
+    return this->randomEngine() % bound;
+}
+
+void World::seedRandom(uint32_t seed)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    this->randomEngine.seed(seed);
+}
+
+namespace
+{
+world::CheckpointID toCheckpointID(essentials::IdentifierConstPtr id)
+{
+    world::CheckpointID checkpointID;
+    checkpointID.type = id->getType();
+    checkpointID.bytes.assign(id->getRaw(), id->getRaw() + id->getSize());
+    return checkpointID;
+}
+} // namespace
+
+void World::captureCheckpoint(world::Checkpoint& checkpoint) const
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    checkpoint.sizeX = this->sizeX;
+    checkpoint.sizeY = this->sizeY;
+    std::ostringstream randomState;
+    randomState << this->randomEngine;
+    checkpoint.randomState = randomState.str();
+    checkpoint.objects.clear();
+    checkpoint.objects.reserve(this->objects.size());
+    for (auto& objectEntry : this->objects) {
+        const world::Object& object = *objectEntry.second;
+        world::CheckpointObject checkpointObject;
+        checkpointObject.id = toCheckpointID(object.getID());
+        checkpointObject.type = object.getType();
+        checkpointObject.state = object.getState();
+        checkpointObject.container = world::CheckpointObject::Container::None;
+        checkpointObject.x = -1;
+        checkpointObject.y = -1;
+        std::shared_ptr<const world::ObjectSet> parent = object.getParentContainer();
+        if (std::shared_ptr<const world::Cell> cell = std::dynamic_pointer_cast<const world::Cell>(parent)) {
+            checkpointObject.container = world::CheckpointObject::Container::Cell;
+            checkpointObject.x = cell->coordinate.x;
+            checkpointObject.y = cell->coordinate.y;
+        } else if (std::shared_ptr<const world::Object> parentObject = std::dynamic_pointer_cast<const world::Object>(parent)) {
+            checkpointObject.container = world::CheckpointObject::Container::Object;
+            checkpointObject.parent = toCheckpointID(parentObject->getID());
+        }
+        checkpoint.objects.push_back(std::move(checkpointObject));
+    }
+}
+
+/**
+ * Objects are moved into their containers without placement checks, so the restored world is exactly
+ * the checkpointed one, e.g., with an agent standing in a door that was closed afterwards.
+ */
+bool World::restoreCheckpoint(
+        const world::Checkpoint& checkpoint, essentials::IDManager& idManager, std::vector<std::shared_ptr<world::Agent>>& restoredAgents)
+{
+    std::lock_guard<std::recursive_mutex> guard(dataMutex);
+    restoredAgents.clear();
+    if (checkpoint.sizeX != this->sizeX || checkpoint.sizeY != this->sizeY) {
+        std::cerr << "[World] Checkpoint of a " << checkpoint.sizeX << "x" << checkpoint.sizeY << " world doesn't fit this " << this->sizeX << "x"
+                  << this->sizeY << " world!" << std::endl;
+        return false;
+    }
+    std::istringstream randomState(checkpoint.randomState);
+    randomState >> this->randomEngine;
+    this->topologyVersion++;
+
+    std::vector<std::shared_ptr<world::Object>> restoredObjects;
+    restoredObjects.reserve(checkpoint.objects.size());
+    for (const world::CheckpointObject& checkpointObject : checkpoint.objects) {
+        essentials::IdentifierConstPtr id = idManager.getIDFromBytes(checkpointObject.id.bytes.data(), checkpointObject.id.bytes.size(), checkpointObject.id.type);
+        std::shared_ptr<world::Object> object = this->createOrUpdateObject(id, checkpointObject.type, checkpointObject.state);
+        restoredObjects.push_back(object);
+        if (std::shared_ptr<world::Agent> agent = std::dynamic_pointer_cast<world::Agent>(object)) {
+            this->addAgent(agent);
+            restoredAgents.push_back(agent);
+        }
+    }
+    // restored objects replace their placements still waiting for a chunk, e.g., of the scenario
+    if (!this->pendingObjects.empty()) {
+        std::unordered_set<std::shared_ptr<world::Object>> restoredSet(restoredObjects.begin(), restoredObjects.end());
+        for (auto pending = this->pendingObjects.begin(); pending != this->pendingObjects.end();) {
+            std::vector<std::pair<std::shared_ptr<world::Object>, world::Coordinate>>& objects = pending->second;
+            objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                  [&restoredSet](const std::pair<std::shared_ptr<world::Object>, world::Coordinate>& objectCoordinatePair) {
+                                      return restoredSet.count(objectCoordinatePair.first) > 0;
+                                  }),
+                    objects.end());
+            if (objects.empty()) {
+                pending = this->pendingObjects.erase(pending);
+            } else {
+                ++pending;
+            }
+        }
+    }
+    // containers are restored after all objects exist, carried objects may come before their agent
+    for (size_t i = 0; i < restoredObjects.size(); i++) {
+        const world::CheckpointObject& checkpointObject = checkpoint.objects[i];
+        std::shared_ptr<world::ObjectSet> container;
+        if (checkpointObject.container == world::CheckpointObject::Container::Cell) {
+            container = this->editCell(world::Coordinate(checkpointObject.x, checkpointObject.y));
+        } else if (checkpointObject.container == world::CheckpointObject::Container::Object) {
+            container = this->editObject(
+                    idManager.getIDFromBytes(checkpointObject.parent.bytes.data(), checkpointObject.parent.bytes.size(), checkpointObject.parent.type));
+        }
+        if (container) {
+            container->addObject(restoredObjects[i]);
+        } else if (checkpointObject.container != world::CheckpointObject::Container::None) {
+            std::cerr << "[World] Container of restored " << restoredObjects[i]->getType() << " doesn't exist!" << std::endl;
+        }
+    }
+    std::cout << "[World] Restored " << restoredObjects.size() << " objects and " << restoredAgents.size() << " agents" << std::endl;
+    return true;
+}
+
 std::recursive_mutex& World::getDataMutex()
 {
     return this->dataMutex;
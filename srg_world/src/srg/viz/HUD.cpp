@@ -0,0 +1,145 @@
+#include "srg/viz/HUD.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace srg
+{
+namespace viz
+{
+HUD::Series::Series()
+        : samples(sampleCount, 0.0f)
+        , next(0)
+        , count(0)
+        , latest(0)
+{
+}
+
+void HUD::Series::add(float sample)
+{
+    this->samples[this->next] = sample;
+    this->next = (this->next + 1) % this->samples.size();
+    this->count = std::min(this->count + 1, this->samples.size());
+    this->latest = sample;
+}
+
+float HUD::Series::getMax() const
+{
+    float max = 0;
+    for (size_t i = 0; i < this->count; i++) {
+        max = std::max(max, this->samples[i]);
+    }
+    return max;
+}
+
+HUD::HUD(std::string fontFile)
+        : overruns(0)
+        , graphs(sf::Lines)
+        , lastTick(0)
+{
+    this->series[TickTime].label = "tick";
+    this->series[FrameTime].label = "frame";
+    this->series[Commands].label = "commands";
+    this->series[PerceptionMessages].label = "perceptions";
+    this->series[PerceptionBytes].label = "perception bytes";
+    this->series[Agents].label = "agents";
+    this->series[ActiveChunks].label = "active chunks";
+    this->series[ResidentChunks].label = "resident chunks";
+    this->series[WorldLockWait].label = "world lock wait";
+
+    this->hasFont = this->font.loadFromFile(fontFile);
+    if (!this->hasFont) {
+        std::cerr << "[HUD] Couldn't load the font " << fontFile << ", only drawing the graphs!" << std::endl;
+    }
+    this->text.setFont(this->font);
+    this->text.setCharacterSize(12);
+    this->text.setFillColor(sf::Color::White);
+    this->background.setSize(sf::Vector2f(width, rowHeight * MetricCount + 8));
+    this->background.setFillColor(sf::Color(0, 0, 0, 170));
+}
+
+void HUD::update(const WorldSnapshot& snapshot)
+{
+    const SimulatorStats& stats = snapshot.stats;
+    if (snapshot.tick == this->lastTick) {
+        return;
+    }
+    float seconds = std::chrono::duration<float>(stats.time - this->lastStats.time).count();
+    if (this->lastTick != 0 && seconds > 0) {
+        this->series[Commands].add((stats.commands - this->lastStats.commands) / seconds);
+        this->series[PerceptionMessages].add((stats.perceptionMessages - this->lastStats.perceptionMessages) / seconds);
+        this->series[PerceptionBytes].add((stats.perceptionBytes - this->lastStats.perceptionBytes) / seconds);
+    }
+    this->series[TickTime].add(std::chrono::duration<float, std::milli>(stats.tickTime).count());
+    this->series[Agents].add(stats.agents);
+    this->series[ActiveChunks].add(stats.activeChunks);
+    this->series[ResidentChunks].add(stats.residentChunks);
+    this->series[WorldLockWait].add(std::chrono::duration<float, std::milli>(stats.worldLockWait).count());
+    this->overruns = stats.overruns;
+    this->lastTick = snapshot.tick;
+    this->lastStats = stats;
+}
+
+void HUD::addFrameTime(std::chrono::steady_clock::duration frameTime)
+{
+    this->series[FrameTime].add(std::chrono::duration<float, std::milli>(frameTime).count());
+}
+
+void HUD::draw(sf::RenderTarget& target)
+{
+    sf::View worldView = target.getView();
+    target.setView(target.getDefaultView());
+    target.draw(this->background);
+
+    this->graphs.clear();
+    const float graphLeft = 140;
+    const float graphWidth = width - graphLeft - 8;
+    for (int metric = 0; metric < MetricCount; metric++) {
+        const Series& series = this->series[metric];
+        float top = 4 + metric * rowHeight;
+        float max = std::max(series.getMax(), 1e-3f);
+        // oldest sample first
+        for (size_t i = 1; i < series.count; i++) {
+            size_t previous = (series.next + series.samples.size() - series.count + i - 1) % series.samples.size();
+            size_t current = (previous + 1) % series.samples.size();
+            float x = graphLeft + graphWidth * (i - 1) / (sampleCount - 1);
+            sf::Color color = metric == TickTime && series.samples[current] >= 30 ? sf::Color::Red : sf::Color::Green;
+            this->graphs.append(sf::Vertex(sf::Vector2f(x, top + rowHeight - 6 - (rowHeight - 10) * series.samples[previous] / max), color));
+            this->graphs.append(
+                    sf::Vertex(sf::Vector2f(x + graphWidth / (sampleCount - 1), top + rowHeight - 6 - (rowHeight - 10) * series.samples[current] / max), color));
+        }
+
+        if (this->hasFont) {
+            std::stringstream label;
+            label << std::fixed << std::setprecision(1) << series.label << "\n" << series.latest;
+            switch (metric) {
+            case TickTime:
+                label << " ms (" << this->overruns << " overruns)";
+                break;
+            case FrameTime:
+            case WorldLockWait:
+                label << " ms";
+                break;
+            case Commands:
+            case PerceptionMessages:
+                label << " /s";
+                break;
+            case PerceptionBytes:
+                label.str("");
+                label << series.label << "\n" << series.latest / 1024 << " KiB/s";
+                break;
+            default:
+                break;
+            }
+            this->text.setString(label.str());
+            this->text.setPosition(6, top);
+            target.draw(this->text);
+        }
+    }
+    target.draw(this->graphs);
+    target.setView(worldView);
+}
+} // namespace viz
+} // namespace srg
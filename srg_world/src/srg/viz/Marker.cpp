@@ -4,8 +4,11 @@ namespace srg
 {
 namespace viz
 {
-Marker::Marker(srg::world::Coordinate coordinate)
-        : coordinate(coordinate)
+Marker::Marker(srg::world::Coordinate coordinate, SpriteType type, uint64_t id, uint32_t lifetime)
+        : type(type)
+        , coordinate(coordinate)
+        , id(id)
+        , lifetime(lifetime)
 {
 }
 } // namespace viz
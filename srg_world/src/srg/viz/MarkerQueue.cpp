@@ -0,0 +1,42 @@
+#include "srg/viz/MarkerQueue.h"
+
+#include <algorithm>
+
+namespace srg
+{
+namespace viz
+{
+MarkerQueue::MarkerQueue()
+        : head(nullptr)
+{
+}
+
+MarkerQueue::~MarkerQueue()
+{
+    for (Batch* batch : this->takeAll()) {
+        delete batch;
+    }
+}
+
+void MarkerQueue::push(Batch* batch)
+{
+    batch->next = this->head.load(std::memory_order_relaxed);
+    while (!this->head.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+std::vector<MarkerQueue::Batch*> MarkerQueue::takeAll()
+{
+    // the consumer detaches the whole list, so nodes are never popped concurrently (no ABA)
+    Batch* batch = this->head.exchange(nullptr, std::memory_order_acquire);
+    std::vector<Batch*> batches;
+    while (batch) {
+        batches.push_back(batch);
+        batch = batch->next;
+    }
+    // pushed as a stack, newest first
+    std::reverse(batches.begin(), batches.end());
+    return batches;
+}
+} // namespace viz
+} // namespace srg
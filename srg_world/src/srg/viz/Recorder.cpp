@@ -0,0 +1,148 @@
+#include "srg/viz/Recorder.h"
+
+#include "srg/viz/WorldRenderer.h"
+
+#include <essentials/FileSystem.h>
+
+#include <SFML/Graphics/RenderTexture.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace srg
+{
+namespace viz
+{
+Recorder::Recorder(std::string directory, Format format, uint32_t width, uint32_t height, size_t queueSize, float lodPixelsPerCell)
+        : directory(directory)
+        , format(format)
+        , width(width)
+        , height(height)
+        , queueSize(std::max(size_t(1), queueSize))
+        , lodPixelsPerCell(lodPixelsPerCell)
+        , running(true)
+        , writtenFrames(0)
+        , droppedFrames(0)
+{
+    if (!essentials::FileSystem::pathExists(this->directory)) {
+        essentials::FileSystem::createDirectory(this->directory, 755);
+    }
+    this->renderThread = new std::thread(&Recorder::renderLoop, this);
+    this->encoderThread = new std::thread(&Recorder::encodeLoop, this);
+}
+
+Recorder::~Recorder()
+{
+    this->running = false;
+    this->snapshots.notify();
+    this->renderThread->join();
+    this->framesCondition.notify_all();
+    this->encoderThread->join();
+    delete this->renderThread;
+    delete this->encoderThread;
+    for (Frame* frame : this->frames) {
+        delete frame;
+    }
+    std::cout << "[Recorder] Wrote " << this->writtenFrames << " frames to " << this->directory << ", dropped " << this->droppedFrames << std::endl;
+}
+
+void Recorder::publish(const WorldSnapshot& snapshot)
+{
+    this->snapshots.publish(snapshot);
+}
+
+uint64_t Recorder::getWrittenFrames() const
+{
+    return this->writtenFrames;
+}
+
+uint64_t Recorder::getDroppedFrames() const
+{
+    return this->droppedFrames;
+}
+
+void Recorder::renderLoop()
+{
+    sf::RenderTexture target;
+    if (!target.create(this->width, this->height)) {
+        std::cerr << "[Recorder] Unable to create an offscreen texture of " << this->width << "x" << this->height << ", recording disabled!" << std::endl;
+        return;
+    }
+    WorldRenderer renderer(this->lodPixelsPerCell);
+
+    while (this->running) {
+        if (!this->snapshots.update(std::chrono::milliseconds(100))) {
+            continue;
+        }
+        const WorldSnapshot& snapshot = this->snapshots.getCurrent();
+        if (snapshot.sizeX == 0 || snapshot.sizeY == 0) {
+            continue;
+        }
+        // the whole world fits into the frame
+        float spriteSize = std::min(float(this->width) / snapshot.sizeX, float(this->height) / snapshot.sizeY);
+        target.clear();
+        renderer.render(target, snapshot, spriteSize, spriteSize);
+        target.display();
+
+        Frame* frame = new Frame();
+        frame->tick = snapshot.tick;
+        frame->image = target.getTexture().copyToImage();
+        {
+            std::lock_guard<std::mutex> guard(this->framesMutex);
+            if (this->frames.size() < this->queueSize) {
+                this->frames.push_back(frame);
+                frame = nullptr;
+            }
+        }
+        if (frame) {
+            this->droppedFrames++;
+            delete frame;
+        } else {
+            this->framesCondition.notify_one();
+        }
+    }
+}
+
+void Recorder::encodeLoop()
+{
+    std::ofstream rawFile;
+    if (this->format == Format::Raw) {
+        rawFile.open(essentials::FileSystem::combinePaths(this->directory, "frames.rgba"), std::ios::binary | std::ios::trunc);
+        if (!rawFile) {
+            std::cerr << "[Recorder] Unable to open " << this->directory << "/frames.rgba for writing!" << std::endl;
+        }
+    }
+
+    while (true) {
+        Frame* frame;
+        {
+            std::unique_lock<std::mutex> lock(this->framesMutex);
+            this->framesCondition.wait(lock, [this]() { return !this->frames.empty() || !this->running; });
+            if (this->frames.empty()) {
+                // the queue is drained before shutting down
+                return;
+            }
+            frame = this->frames.front();
+            this->frames.pop_front();
+        }
+
+        if (this->format == Format::Raw) {
+            if (rawFile.write(reinterpret_cast<const char*>(frame->image.getPixelsPtr()), std::streamsize(this->width) * this->height * 4)) {
+                this->writtenFrames++;
+            }
+        } else {
+            char fileName[32];
+            snprintf(fileName, sizeof(fileName), "frame_%08llu.png", static_cast<unsigned long long>(frame->tick));
+            if (frame->image.saveToFile(essentials::FileSystem::combinePaths(this->directory, fileName))) {
+                this->writtenFrames++;
+            } else {
+                std::cerr << "[Recorder] Unable to write " << fileName << std::endl;
+            }
+        }
+        delete frame;
+    }
+}
+} // namespace viz
+} // namespace srg
@@ -0,0 +1,58 @@
+#include "srg/viz/SnapshotBuffer.h"
+
+namespace srg
+{
+namespace viz
+{
+SnapshotBuffer::SnapshotBuffer()
+        : building(new WorldSnapshot())
+        , published(new WorldSnapshot())
+        , current(new WorldSnapshot())
+        , fresh(false)
+{
+}
+
+SnapshotBuffer::~SnapshotBuffer()
+{
+    delete this->building;
+    delete this->published;
+    delete this->current;
+}
+
+void SnapshotBuffer::publish(const WorldSnapshot& snapshot)
+{
+    // copying reuses the capacity of the building snapshot
+    *this->building = snapshot;
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        std::swap(this->building, this->published);
+        this->fresh = true;
+    }
+    this->freshCondition.notify_one();
+}
+
+bool SnapshotBuffer::update(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (!this->fresh && timeout.count() > 0) {
+        this->freshCondition.wait_for(lock, timeout);
+    }
+    if (!this->fresh) {
+        return false;
+    }
+    std::swap(this->published, this->current);
+    this->fresh = false;
+    return true;
+}
+
+const WorldSnapshot& SnapshotBuffer::getCurrent() const
+{
+    return *this->current;
+}
+
+void SnapshotBuffer::notify()
+{
+    this->freshCondition.notify_all();
+}
+} // namespace viz
+} // namespace srg
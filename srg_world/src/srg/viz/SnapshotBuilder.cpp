@@ -0,0 +1,291 @@
+#include "srg/viz/SnapshotBuilder.h"
+
+#include <srg/World.h>
+#include <srg/world/Agent.h>
+#include <srg/world/Cell.h>
+#include <srg/world/Door.h>
+#include <srg/world/Object.h>
+#include <srg/world/Room.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <tuple>
+
+//#define SNAPSHOT_DEBUG
+
+namespace srg
+{
+namespace viz
+{
+SnapshotBuilder::SnapshotBuilder()
+        : staticVersion(0)
+        , staticCellCount(0)
+        , tick(0)
+        , markerVersion(0)
+{
+}
+
+void SnapshotBuilder::addMarker(Marker marker)
+{
+    MarkerQueue::Batch* batch = new MarkerQueue::Batch();
+    batch->markers.push_back(marker);
+    this->markerQueue.push(batch);
+}
+
+void SnapshotBuilder::addMarkers(std::vector<Marker> markers)
+{
+    MarkerQueue::Batch* batch = new MarkerQueue::Batch();
+    batch->markers = std::move(markers);
+    this->markerQueue.push(batch);
+}
+
+void SnapshotBuilder::removeMarker(uint64_t id)
+{
+    MarkerQueue::Batch* batch = new MarkerQueue::Batch();
+    batch->removedIDs.push_back(id);
+    this->markerQueue.push(batch);
+}
+
+void SnapshotBuilder::clearMarkers()
+{
+    MarkerQueue::Batch* batch = new MarkerQueue::Batch();
+    batch->clear = true;
+    this->markerQueue.push(batch);
+}
+
+void SnapshotBuilder::discardMarkers()
+{
+    for (MarkerQueue::Batch* batch : this->markerQueue.takeAll()) {
+        delete batch;
+    }
+}
+
+void SnapshotBuilder::build(World* world, WorldSnapshot& snapshot, uint64_t tick)
+{
+    snapshot.dynamicSprites.clear();
+    {
+        std::recursive_mutex& dataMutex = world->getDataMutex();
+        auto lockStart = std::chrono::steady_clock::now();
+        std::lock_guard<std::recursive_mutex> guard(dataMutex);
+        snapshot.stats.time = std::chrono::steady_clock::now().time_since_epoch();
+        snapshot.stats.worldLockWait = snapshot.stats.time - lockStart.time_since_epoch();
+        snapshot.sizeX = world->getSizeX();
+        snapshot.sizeY = world->getSizeY();
+
+        if (this->staticCellCount != world->getGrid().size()) {
+            std::shared_ptr<std::vector<SpriteInstance>> sprites = std::make_shared<std::vector<SpriteInstance>>();
+            sprites->reserve(world->getGrid().size());
+            for (auto& coordinateCellPair : world->getGrid()) {
+                sprites->emplace_back(this->getSpriteType(coordinateCellPair.second->getType()), coordinateCellPair.first.x, coordinateCellPair.first.y);
+            }
+            this->staticSprites = sprites;
+            this->roomAreas = this->createRoomAreas(world);
+            this->staticCellCount = world->getGrid().size();
+            this->staticVersion++;
+        }
+
+        if (world->getChunkSize() > 0) {
+            this->collectChunkSprites(world, snapshot.dynamicSprites);
+        } else {
+            for (auto& coordinateCellPair : world->getGrid()) {
+                this->appendObjectSprites(coordinateCellPair.second.get(), snapshot.dynamicSprites);
+            }
+        }
+    }
+    snapshot.staticSprites = this->staticSprites;
+    snapshot.roomAreas = this->roomAreas;
+    snapshot.staticVersion = this->staticVersion;
+    this->tick = tick;
+    snapshot.tick = tick;
+
+    // for debug purposes
+    this->updateMarkers();
+    snapshot.markerSprites = this->markerSprites;
+    snapshot.markerVersion = this->markerVersion;
+}
+
+void SnapshotBuilder::appendObjectSprites(const world::Cell* cell, std::vector<SpriteInstance>& sprites)
+{
+    const world::Coordinate& coordinate = cell->coordinate;
+    for (auto& objectEntry : cell->getObjects()) {
+        sprites.emplace_back(this->getSpriteType(objectEntry.second), coordinate.x, coordinate.y);
+
+        if (std::shared_ptr<world::Agent> robot = std::dynamic_pointer_cast<world::Agent>(objectEntry.second)) {
+            if (robot->getObjects().size() > 0) {
+                // carried object
+                sprites.emplace_back(this->getSpriteType(robot->getObjects().begin()->second), coordinate.x + 0.5f, coordinate.y + 0.5f, 0.25f);
+            }
+        }
+#ifdef SNAPSHOT_DEBUG
+        std::cout << "SnapshotBuilder: Placing object of Type " << objectEntry.second->getType() << " at " << coordinate << std::endl;
+#endif
+    }
+}
+
+/**
+ * Commands change cells next to agents in chunks that were active when the previous snapshot was built,
+ * displacements change cells in chunks active now, so both are collected again.
+ */
+void SnapshotBuilder::collectChunkSprites(World* world, std::vector<SpriteInstance>& sprites)
+{
+    uint32_t chunkCount = world->getChunkCount();
+    if (this->chunkSprites.size() != chunkCount) {
+        this->chunkSprites.assign(chunkCount, std::vector<SpriteInstance>());
+        this->cachedChunks.assign(chunkCount, false);
+        this->previouslyActiveChunks.assign(chunkCount, false);
+    }
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+        if (!world->isChunkResident(chunk)) {
+            continue;
+        }
+        bool active = world->isChunkActive(chunk);
+        if (active || this->previouslyActiveChunks[chunk] || !this->cachedChunks[chunk]) {
+            this->chunkSprites[chunk].clear();
+            world->collectChunkCells(chunk, this->chunkCells);
+            for (const world::Cell* cell : this->chunkCells) {
+                this->appendObjectSprites(cell, this->chunkSprites[chunk]);
+            }
+            this->cachedChunks[chunk] = true;
+        }
+        this->previouslyActiveChunks[chunk] = active;
+        sprites.insert(sprites.end(), this->chunkSprites[chunk].begin(), this->chunkSprites[chunk].end());
+    }
+}
+
+/**
+ * Applies the submitted marker batches, removes expired markers and rebuilds the
+ * marker sprites if anything changed.
+ */
+void SnapshotBuilder::updateMarkers()
+{
+    bool changed = false;
+    for (MarkerQueue::Batch* batch : this->markerQueue.takeAll()) {
+        if (batch->clear) {
+            this->namedMarkers.clear();
+            this->anonymousMarkers.clear();
+        }
+        for (uint64_t id : batch->removedIDs) {
+            this->namedMarkers.erase(id);
+        }
+        for (const Marker& marker : batch->markers) {
+            uint64_t expiry = marker.lifetime == 0 ? 0 : this->tick + marker.lifetime;
+            if (marker.id == 0) {
+                this->anonymousMarkers.emplace_back(marker, expiry);
+            } else {
+                auto entry = this->namedMarkers.find(marker.id);
+                if (entry == this->namedMarkers.end()) {
+                    this->namedMarkers.emplace(marker.id, ActiveMarker(marker, expiry));
+                } else {
+                    entry->second = ActiveMarker(marker, expiry);
+                }
+            }
+        }
+        changed = true;
+        delete batch;
+    }
+
+    auto expired = [this](const ActiveMarker& activeMarker) { return activeMarker.expiry != 0 && activeMarker.expiry <= this->tick; };
+    size_t anonymousCount = this->anonymousMarkers.size();
+    this->anonymousMarkers.erase(std::remove_if(this->anonymousMarkers.begin(), this->anonymousMarkers.end(), expired), this->anonymousMarkers.end());
+    changed |= anonymousCount != this->anonymousMarkers.size();
+    for (auto entry = this->namedMarkers.begin(); entry != this->namedMarkers.end();) {
+        if (expired(entry->second)) {
+            entry = this->namedMarkers.erase(entry);
+            changed = true;
+        } else {
+            ++entry;
+        }
+    }
+
+    if (!changed) {
+        return;
+    }
+    std::shared_ptr<std::vector<SpriteInstance>> sprites = std::make_shared<std::vector<SpriteInstance>>();
+    sprites->reserve(this->anonymousMarkers.size() + this->namedMarkers.size());
+    for (const ActiveMarker& activeMarker : this->anonymousMarkers) {
+        sprites->emplace_back(activeMarker.marker.type, activeMarker.marker.coordinate.x + 0.25f, activeMarker.marker.coordinate.y + 0.25f, 0.25f);
+    }
+    for (auto& entry : this->namedMarkers) {
+        sprites->emplace_back(entry.second.marker.type, entry.second.marker.coordinate.x + 0.25f, entry.second.marker.coordinate.y + 0.25f, 0.25f);
+    }
+    this->markerSprites = sprites;
+    this->markerVersion++;
+}
+
+/**
+ * Decomposes the rooms into rectangles by merging vertical runs of cells with runs of the same room and extent
+ * in the previous column. Has to be called with the data mutex of the world locked.
+ */
+std::shared_ptr<const std::vector<RoomArea>> SnapshotBuilder::createRoomAreas(World* world)
+{
+    std::shared_ptr<std::vector<RoomArea>> areas = std::make_shared<std::vector<RoomArea>>();
+    // (room, first y, last y) -> index of the area ending in the previous column
+    std::map<std::tuple<const world::Room*, uint32_t, uint32_t>, size_t> openAreas;
+    const world::Cell* runStart = nullptr;
+    const world::Cell* runEnd = nullptr;
+    auto closeRun = [&]() {
+        if (!runStart) {
+            return;
+        }
+        auto key = std::make_tuple(runStart->room, runStart->coordinate.y, runEnd->coordinate.y);
+        auto openArea = openAreas.find(key);
+        if (openArea != openAreas.end() && (*areas)[openArea->second].x + (*areas)[openArea->second].width == runStart->coordinate.x) {
+            (*areas)[openArea->second].width += 1;
+        } else {
+            areas->emplace_back(runStart->getType(), runStart->coordinate.x, runStart->coordinate.y, 1, runEnd->coordinate.y - runStart->coordinate.y + 1);
+            openAreas[key] = areas->size() - 1;
+        }
+        runStart = nullptr;
+    };
+
+    // the grid is ordered by x, then y
+    for (auto& coordinateCellPair : world->getGrid()) {
+        const world::Cell* cell = coordinateCellPair.second.get();
+        if (runStart && (cell->coordinate.x != runEnd->coordinate.x || cell->coordinate.y != runEnd->coordinate.y + 1 || cell->room != runStart->room)) {
+            closeRun();
+        }
+        if (!runStart) {
+            runStart = cell;
+        }
+        runEnd = cell;
+    }
+    closeRun();
+    return areas;
+}
+
+SpriteType SnapshotBuilder::getSpriteType(world::RoomType type)
+{
+    if (type == world::RoomType::Wall) {
+        return SpriteType::Wall;
+    }
+    return SpriteType::Floor;
+}
+
+SpriteType SnapshotBuilder::getSpriteType(std::shared_ptr<const world::Object> object)
+{
+    switch (object->getType()) {
+    case world::ObjectType::Door:
+        if (std::dynamic_pointer_cast<const world::Door>(object)->isOpen()) {
+            return SpriteType::DoorOpen;
+        } else {
+            return SpriteType::DoorClosed;
+        }
+    case world::ObjectType::CupBlue:
+        return SpriteType::CupBlue;
+    case world::ObjectType::CupYellow:
+        return SpriteType::CupYellow;
+    case world::ObjectType::CupRed:
+        return SpriteType::CupRed;
+    case world::ObjectType::Robot:
+        return SpriteType::Robot;
+    case world::ObjectType::Human:
+        return SpriteType::Human;
+    default:
+        std::cerr << "[SnapshotBuilder] Unknown object type encountered!" << object->getType() << std::endl;
+        return SpriteType::Unknown;
+    }
+}
+} // namespace viz
+} // namespace srg
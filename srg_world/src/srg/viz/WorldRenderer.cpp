@@ -0,0 +1,248 @@
+#include "srg/viz/WorldRenderer.h"
+
+#include <essentials/SystemConfig.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace srg
+{
+namespace viz
+{
+WorldRenderer::WorldRenderer(float lodPixelsPerCell)
+        : lodPixelsPerCell(lodPixelsPerCell)
+{
+    std::string textureFile = essentials::SystemConfig::getInstance().getConfigPath() + "/textures/textures.png";
+    std::cout << "[WorldRenderer] Info: loading textureFile '" << textureFile << "'" << std::endl;
+    this->texture = new sf::Texture();
+    if (!this->texture->loadFromFile(textureFile)) {
+        std::cerr << "[WorldRenderer] Couldn't load the texture file " << textureFile << std::endl;
+    }
+    this->texture->setSmooth(true);
+    this->texture->setRepeated(true);
+    this->dynamicLayer.setPrimitiveType(sf::Quads);
+    this->roomLayer.setPrimitiveType(sf::Quads);
+    this->markerLayer.setPrimitiveType(sf::Quads);
+    for (int i = 0; i != static_cast<int>(SpriteType::Last); i++) {
+        sf::IntRect& rect = this->textureRects[i];
+        SpriteType type = static_cast<SpriteType>(i);
+        switch (type) {
+        case SpriteType::Wall:
+            rect = sf::IntRect(textureSize * 2, 0, textureSize, textureSize);
+            break;
+        case SpriteType::DoorOpen:
+            rect = sf::IntRect(textureSize * 3, 0, textureSize, textureSize);
+            break;
+        case SpriteType::DoorClosed:
+            rect = sf::IntRect(textureSize * 3, textureSize, textureSize, textureSize);
+            break;
+        case SpriteType::Floor:
+            rect = sf::IntRect(textureSize * 2, textureSize, textureSize, textureSize);
+            break;
+        case SpriteType::Unknown:
+            rect = sf::IntRect(textureSize, textureSize, textureSize, textureSize);
+            break;
+        case SpriteType::Robot:
+            rect = sf::IntRect(0, textureSize * 2, textureSize, textureSize);
+            break;
+        case SpriteType::CupBlue:
+            rect = sf::IntRect(textureSize, textureSize * 3, textureSize, textureSize);
+            break;
+        case SpriteType::CupRed:
+            rect = sf::IntRect(0, textureSize * 3, textureSize, textureSize);
+            break;
+        case SpriteType::CupYellow:
+            rect = sf::IntRect(textureSize * 2, textureSize * 3, textureSize, textureSize);
+            break;
+        case SpriteType::Human:
+            rect = sf::IntRect(textureSize * 3, textureSize * 3, textureSize, textureSize);
+            break;
+        default:
+            rect = sf::IntRect(0, 0, textureSize, textureSize);
+            std::cout << "[WorldRenderer] Unknown cell type " << static_cast<int>(type) << std::endl;
+        }
+    }
+}
+
+WorldRenderer::~WorldRenderer()
+{
+    delete this->texture;
+}
+
+void WorldRenderer::render(sf::RenderTarget& target, const WorldSnapshot& snapshot, float spriteSize, float pixelsPerCell)
+{
+    if (snapshot.sizeX == 0 || snapshot.sizeY == 0 || spriteSize <= 0) {
+        // nothing published yet
+        return;
+    }
+    this->spriteSize = spriteSize;
+    if (this->staticLayerSpriteSize != this->spriteSize || this->staticLayerVersion != snapshot.staticVersion) {
+        this->buildStaticLayer(snapshot);
+    }
+    sf::FloatRect visibleCells = this->calculateVisibleCells(target);
+
+    if (pixelsPerCell < this->lodPixelsPerCell) {
+        this->buildAggregatedLayer(snapshot, visibleCells);
+        target.draw(this->roomLayer);
+    } else {
+        this->buildDynamicLayer(snapshot, visibleCells);
+        for (uint32_t chunkX = std::max(0, int(visibleCells.left) / int(chunkSize));
+                chunkX < this->chunksX && chunkX * chunkSize <= visibleCells.left + visibleCells.width; chunkX++) {
+            for (uint32_t chunkY = std::max(0, int(visibleCells.top) / int(chunkSize));
+                    chunkY < this->chunksY && chunkY * chunkSize <= visibleCells.top + visibleCells.height; chunkY++) {
+                target.draw(this->staticChunks[chunkX * this->chunksY + chunkY], this->texture);
+            }
+        }
+    }
+    target.draw(this->dynamicLayer, this->texture);
+
+    if (this->markerLayerSpriteSize != this->spriteSize || this->markerLayerVersion != snapshot.markerVersion) {
+        this->buildMarkerLayer(snapshot);
+    }
+    target.draw(this->markerLayer, this->texture);
+}
+
+/**
+ * The part of the world covered by the current view, in cells.
+ */
+sf::FloatRect WorldRenderer::calculateVisibleCells(const sf::RenderTarget& target)
+{
+    const sf::View& view = target.getView();
+    sf::Vector2f topLeft = view.getCenter() - view.getSize() / 2.0f;
+    return sf::FloatRect(topLeft.x / this->spriteSize, topLeft.y / this->spriteSize, view.getSize().x / this->spriteSize,
+            view.getSize().y / this->spriteSize);
+}
+
+void WorldRenderer::buildStaticLayer(const WorldSnapshot& snapshot)
+{
+    this->chunksX = (snapshot.sizeX + chunkSize - 1) / chunkSize;
+    this->chunksY = (snapshot.sizeY + chunkSize - 1) / chunkSize;
+    this->staticChunks.assign(this->chunksX * this->chunksY, sf::VertexArray(sf::Quads));
+    if (snapshot.staticSprites) {
+        for (const SpriteInstance& sprite : *snapshot.staticSprites) {
+            uint32_t chunkX = std::min(uint32_t(sprite.x) / chunkSize, this->chunksX - 1);
+            uint32_t chunkY = std::min(uint32_t(sprite.y) / chunkSize, this->chunksY - 1);
+            this->appendQuad(this->staticChunks[chunkX * this->chunksY + chunkY], sprite);
+        }
+    }
+    this->roomLayer.clear();
+    if (snapshot.roomAreas) {
+        for (const RoomArea& area : *snapshot.roomAreas) {
+            this->appendQuad(this->roomLayer, area);
+        }
+    }
+    this->staticLayerSpriteSize = this->spriteSize;
+    this->staticLayerVersion = snapshot.staticVersion;
+}
+
+void WorldRenderer::buildDynamicLayer(const WorldSnapshot& snapshot, const sf::FloatRect& visibleCells)
+{
+    this->dynamicLayer.clear();
+    for (const SpriteInstance& sprite : snapshot.dynamicSprites) {
+        if (visibleCells.intersects(sf::FloatRect(sprite.x, sprite.y, sprite.size, sprite.size))) {
+            this->appendQuad(this->dynamicLayer, sprite);
+        }
+    }
+}
+
+void WorldRenderer::buildMarkerLayer(const WorldSnapshot& snapshot)
+{
+    this->markerLayer.clear();
+    if (snapshot.markerSprites) {
+        for (const SpriteInstance& sprite : *snapshot.markerSprites) {
+            this->appendQuad(this->markerLayer, sprite);
+        }
+    }
+    this->markerLayerSpriteSize = this->spriteSize;
+    this->markerLayerVersion = snapshot.markerVersion;
+}
+
+/**
+ * One sprite per block of cells with objects, of the first agent or else the first object type in the block.
+ * Its size grows with the number of objects.
+ */
+void WorldRenderer::buildAggregatedLayer(const WorldSnapshot& snapshot, const sf::FloatRect& visibleCells)
+{
+    this->aggregatedObjects.clear();
+    for (const SpriteInstance& sprite : snapshot.dynamicSprites) {
+        if (!visibleCells.intersects(sf::FloatRect(sprite.x, sprite.y, sprite.size, sprite.size))) {
+            continue;
+        }
+        uint64_t block = (uint64_t(sprite.x / lodBlockSize) << 32) | uint32_t(sprite.y / lodBlockSize);
+        auto entry = this->aggregatedObjects.emplace(block, std::make_pair(sprite.type, 0u)).first;
+        if (sprite.type == SpriteType::Robot || sprite.type == SpriteType::Human) {
+            entry->second.first = sprite.type;
+        }
+        entry->second.second++;
+    }
+
+    this->dynamicLayer.clear();
+    for (auto& entry : this->aggregatedObjects) {
+        float size = std::min(float(lodBlockSize), lodBlockSize * (0.25f + 0.25f * std::log2(float(entry.second.second))));
+        float x = (entry.first >> 32) * lodBlockSize + (lodBlockSize - size) / 2;
+        float y = (entry.first & 0xFFFFFFFF) * lodBlockSize + (lodBlockSize - size) / 2;
+        this->appendQuad(this->dynamicLayer, SpriteInstance(entry.second.first, x, y, size));
+    }
+}
+
+void WorldRenderer::appendQuad(sf::VertexArray& vertices, const SpriteInstance& sprite)
+{
+    const sf::IntRect& rect = this->textureRects[static_cast<int>(sprite.type)];
+    float left = rect.left;
+    float top = rect.top;
+    float right = rect.left + rect.width;
+    float bottom = rect.top + rect.height;
+    float x = sprite.x * this->spriteSize;
+    float y = sprite.y * this->spriteSize;
+    float size = sprite.size * this->spriteSize;
+    vertices.append(sf::Vertex(sf::Vector2f(x, y), sf::Vector2f(left, top)));
+    vertices.append(sf::Vertex(sf::Vector2f(x + size, y), sf::Vector2f(right, top)));
+    vertices.append(sf::Vertex(sf::Vector2f(x + size, y + size), sf::Vector2f(right, bottom)));
+    vertices.append(sf::Vertex(sf::Vector2f(x, y + size), sf::Vector2f(left, bottom)));
+}
+
+void WorldRenderer::appendQuad(sf::VertexArray& vertices, const RoomArea& area)
+{
+    sf::Color color = this->getColor(area.type);
+    float x = area.x * this->spriteSize;
+    float y = area.y * this->spriteSize;
+    float width = area.width * this->spriteSize;
+    float height = area.height * this->spriteSize;
+    vertices.append(sf::Vertex(sf::Vector2f(x, y), color));
+    vertices.append(sf::Vertex(sf::Vector2f(x + width, y), color));
+    vertices.append(sf::Vertex(sf::Vector2f(x + width, y + height), color));
+    vertices.append(sf::Vertex(sf::Vector2f(x, y + height), color));
+}
+
+sf::Color WorldRenderer::getColor(world::RoomType type)
+{
+    switch (type) {
+    case world::RoomType::Wall:
+        return sf::Color(60, 60, 60);
+    case world::RoomType::Floor:
+        return sf::Color(200, 200, 200);
+    case world::RoomType::Office:
+        return sf::Color(170, 200, 230);
+    case world::RoomType::Bathroom:
+        return sf::Color(150, 220, 220);
+    case world::RoomType::UtilityRoom:
+        return sf::Color(210, 190, 150);
+    case world::RoomType::Kitchen:
+        return sf::Color(240, 200, 140);
+    case world::RoomType::ReceptionRoom:
+        return sf::Color(220, 170, 200);
+    case world::RoomType::ConferenceRoom:
+        return sf::Color(180, 220, 160);
+    case world::RoomType::ServerRoom:
+        return sf::Color(150, 150, 210);
+    case world::RoomType::Storeroom:
+        return sf::Color(190, 170, 140);
+    case world::RoomType::WorkshopRoom:
+        return sf::Color(230, 160, 130);
+    default:
+        return sf::Color(120, 120, 120);
+    }
+}
+} // namespace viz
+} // namespace srg
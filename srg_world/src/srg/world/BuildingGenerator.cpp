@@ -0,0 +1,250 @@
+#include "srg/world/BuildingGenerator.h"
+
+#include "srg/world/Scenario.h"
+
+#include <fstream>
+#include <iostream>
+
+namespace srg
+{
+namespace world
+{
+BuildingGenerator::BuildingGenerator(const BuildingParameters& parameters)
+        : parameters(parameters)
+        , rng(parameters.seed)
+        , sizeX(0)
+        , sizeY(0)
+        , doorCount(0)
+{
+}
+
+/**
+ * Layout of one wing, wings share their outer walls:
+ *
+ *   #########################
+ *   ##....#....#....#....#...   rooms
+ *   ##....#....#....#....#...
+ *   ##############.#######.##   doors
+ *   .........................   corridor
+ *   ##.##########.###########
+ *   ##....#....#....#....#...   rooms
+ *   #########################
+ *
+ * The vertical corridor connecting the wings runs through the first columns.
+ */
+bool BuildingGenerator::generate()
+{
+    const BuildingParameters& p = this->parameters;
+    if (p.wings == 0 || p.roomsPerRow == 0 || p.roomWidth == 0 || p.roomDepth == 0 || p.corridorWidth == 0) {
+        std::cerr << "[BuildingGenerator] Wings, rooms and their sizes have to be at least 1!" << std::endl;
+        return false;
+    }
+    uint64_t roomCount = 1 + uint64_t(p.wings) * (1 + 2 * uint64_t(p.roomsPerRow));
+    if (roomCount >= MapFile::noRoom) {
+        std::cerr << "[BuildingGenerator] " << roomCount << " rooms exceed the limit of " << MapFile::noRoom - 1 << " rooms of the map format!" << std::endl;
+        return false;
+    }
+
+    uint32_t wingHeight = 2 * p.roomDepth + p.corridorWidth + 4;
+    uint32_t firstRoomX = p.corridorWidth + 2;
+    this->sizeX = firstRoomX + p.roomsPerRow * (p.roomWidth + 1);
+    this->sizeY = p.wings * (wingHeight - 1) + 1;
+
+    this->rng.seed(p.seed);
+    this->rooms.clear();
+    this->names.clear();
+    this->objects.clear();
+    this->doorCount = 0;
+    MapFile::CellRecord empty = {MapFile::noRoom, 0, 0};
+    this->cells.assign(size_t(this->sizeX) * this->sizeY, empty);
+
+    this->fill(0, 0, this->sizeX, this->sizeY, this->addRoom("Walls", RoomType::Wall));
+    for (uint32_t wing = 0; wing < p.wings; wing++) {
+        uint32_t top = wing * (wingHeight - 1);
+        uint32_t corridorY = top + p.roomDepth + 2;
+
+        // vertical corridor, opened through the wall to the next wing
+        uint16_t corridor = this->addRoom("Corridor " + std::to_string(wing), RoomType::Floor);
+        this->fill(1, top + 1, p.corridorWidth, wing + 1 < p.wings ? wingHeight - 1 : wingHeight - 2, corridor);
+        this->fill(1, corridorY, this->sizeX - 2, p.corridorWidth, corridor);
+
+        for (uint32_t i = 0; i < p.roomsPerRow; i++) {
+            uint32_t x = firstRoomX + i * (p.roomWidth + 1);
+            this->addOfficeRoom(x, top + 1, x + this->random(p.roomWidth), corridorY - 1);
+            this->addOfficeRoom(x, corridorY + p.corridorWidth + 1, x + this->random(p.roomWidth), corridorY + p.corridorWidth);
+        }
+    }
+    this->placeCups();
+    return true;
+}
+
+void BuildingGenerator::addOfficeRoom(uint32_t x, uint32_t y, uint32_t doorX, uint32_t doorY)
+{
+    // the first room is the reception, next to the entrance of the building
+    RoomType type = this->rooms.size() == 2 ? RoomType::ReceptionRoom : this->randomRoomType();
+    uint16_t room = this->addRoom("Room " + std::to_string(this->rooms.size()), type);
+    this->fill(x, y, this->parameters.roomWidth, this->parameters.roomDepth, room);
+    this->fill(doorX, doorY, 1, 1, room);
+
+    PlacedObject door;
+    door.type = "door";
+    door.x = doorX;
+    door.y = doorY;
+    door.open = this->random(100) < this->parameters.openDoorPercentage;
+    this->objects.push_back(door);
+    this->doorCount++;
+}
+
+/**
+ * Cups are placed on free cells of rooms and corridors, never on walls or doors.
+ */
+void BuildingGenerator::placeCups()
+{
+    static const char* cupTypes[] = {"cup_blue", "cup_red", "cup_yellow"};
+    std::vector<bool> occupied(this->cells.size(), false);
+    for (const PlacedObject& object : this->objects) {
+        occupied[size_t(object.x) * this->sizeY + object.y] = true;
+    }
+
+    uint32_t placed = 0;
+    uint64_t attempts = uint64_t(this->parameters.cups) * 100;
+    for (uint64_t i = 0; i < attempts && placed < this->parameters.cups; i++) {
+        uint32_t x = this->random(this->sizeX);
+        uint32_t y = this->random(this->sizeY);
+        size_t index = size_t(x) * this->sizeY + y;
+        if (occupied[index] || static_cast<RoomType>(this->rooms[this->cells[index].room].type) == RoomType::Wall) {
+            continue;
+        }
+        occupied[index] = true;
+        PlacedObject cup;
+        cup.type = cupTypes[this->random(3)];
+        cup.x = x;
+        cup.y = y;
+        cup.open = false;
+        this->objects.push_back(cup);
+        placed++;
+    }
+    if (placed < this->parameters.cups) {
+        std::cerr << "[BuildingGenerator] Only placed " << placed << " of " << this->parameters.cups << " cups!" << std::endl;
+    }
+}
+
+RoomType BuildingGenerator::randomRoomType()
+{
+    static const std::pair<RoomType, uint32_t> mix[] = {{RoomType::Office, 50}, {RoomType::ConferenceRoom, 10}, {RoomType::Kitchen, 8},
+            {RoomType::Bathroom, 8}, {RoomType::Storeroom, 8}, {RoomType::UtilityRoom, 6}, {RoomType::ServerRoom, 5}, {RoomType::WorkshopRoom, 5}};
+    uint32_t value = this->random(100);
+    for (const auto& entry : mix) {
+        if (value < entry.second) {
+            return entry.first;
+        }
+        value -= entry.second;
+    }
+    return RoomType::Office;
+}
+
+uint32_t BuildingGenerator::random(uint32_t bound)
+{
+    // rejection sampling instead of std::uniform_int_distribution, whose results differ between standard libraries
+    uint32_t limit = uint32_t(0xFFFFFFFFull + 1 - (0x100000000ull % bound));
+    uint32_t value;
+    do {
+        value = this->rng();
+    } while (limit != 0 && value >= limit);
+    return value % bound;
+}
+
+uint16_t BuildingGenerator::addRoom(const std::string& name, RoomType type)
+{
+    MapFile::RoomRecord room = MapFile::RoomRecord();
+    room.id = firstRoomID + this->rooms.size();
+    room.type = static_cast<uint32_t>(type);
+    room.nameOffset = this->names.size();
+    room.nameLength = name.size();
+    this->names += name;
+    this->rooms.push_back(room);
+    return this->rooms.size() - 1;
+}
+
+void BuildingGenerator::fill(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint16_t room)
+{
+    for (uint32_t i = x; i < x + width; i++) {
+        for (uint32_t j = y; j < y + height; j++) {
+            this->cells[size_t(i) * this->sizeY + j].room = room;
+        }
+    }
+}
+
+bool BuildingGenerator::writeMap(const std::string& mapFile) const
+{
+    // the cell types and flags are derived while writing, so the generated cells stay untouched
+    std::vector<MapFile::CellRecord> mapCells = this->cells;
+    return MapFile::write(mapFile, this->parameters.seed, this->sizeX, this->sizeY, this->rooms, this->names, mapCells);
+}
+
+bool BuildingGenerator::writeObjects(const std::string& objectsFile) const
+{
+    std::ofstream out(objectsFile, std::ios::trunc);
+    out << "[Objects]" << std::endl;
+    uint32_t id = firstObjectID;
+    for (const PlacedObject& object : this->objects) {
+        out << "\t[" << id << "]" << std::endl;
+        out << "\t\ttype = " << object.type << std::endl;
+        out << "\t\tx = " << object.x << std::endl;
+        out << "\t\ty = " << object.y << std::endl;
+        if (object.type == "door") {
+            out << "\t\topen = " << (object.open ? "true" : "false") << std::endl;
+        }
+        out << "\t[!" << id << "]" << std::endl;
+        id++;
+    }
+    out << "[!Objects]" << std::endl;
+    if (!out) {
+        std::cerr << "[BuildingGenerator] Unable to write '" << objectsFile << "'!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool BuildingGenerator::writeScenario(const std::string& scenarioFile) const
+{
+    Scenario scenario;
+    int32_t id = firstObjectID;
+    for (const PlacedObject& object : this->objects) {
+        ScenarioObject scenarioObject;
+        scenarioObject.id = id++;
+        Scenario::parseType(object.type.c_str(), scenarioObject.type);
+        scenarioObject.state = object.type == "door" ? (object.open ? ObjectState::Open : ObjectState::Closed) : ObjectState::Undefined;
+        scenarioObject.x = object.x;
+        scenarioObject.y = object.y;
+        scenario.addObject(scenarioObject);
+    }
+    return scenario.write(scenarioFile);
+}
+
+uint32_t BuildingGenerator::getSizeX() const
+{
+    return this->sizeX;
+}
+
+uint32_t BuildingGenerator::getSizeY() const
+{
+    return this->sizeY;
+}
+
+uint32_t BuildingGenerator::getRoomCount() const
+{
+    return this->rooms.size();
+}
+
+uint32_t BuildingGenerator::getDoorCount() const
+{
+    return this->doorCount;
+}
+
+uint32_t BuildingGenerator::getCupCount() const
+{
+    return this->objects.size() - this->doorCount;
+}
+} // namespace world
+} // namespace srg
@@ -17,9 +17,19 @@ Cell::Cell(uint32_t x, uint32_t y)
         , left(nullptr)
         , right(nullptr)
         , room(nullptr)
+        , changed(false)
+        , changedCells(nullptr)
 {
 }
 
+void Cell::markChanged()
+{
+    if (!this->changed && this->changedCells) {
+        this->changed = true;
+        this->changedCells->push_back(this);
+    }
+}
+
 RoomType Cell::getType() const
 {
     return this->room->getType();
@@ -0,0 +1,157 @@
+#include "srg/world/Checkpoint.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+namespace srg
+{
+namespace world
+{
+namespace
+{
+template <typename T>
+void writeValue(std::ofstream& out, T value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::ifstream& in, T& value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+void writeID(std::ofstream& out, const CheckpointID& id)
+{
+    writeValue<uint8_t>(out, id.type);
+    writeValue<uint8_t>(out, id.bytes.size());
+    out.write(reinterpret_cast<const char*>(id.bytes.data()), id.bytes.size());
+}
+
+bool readID(std::ifstream& in, CheckpointID& id)
+{
+    uint8_t size;
+    if (!readValue(in, id.type) || !readValue(in, size)) {
+        return false;
+    }
+    id.bytes.resize(size);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(id.bytes.data()), size));
+}
+
+/**
+ * Bytes left to read, so sizes read from a corrupt file can be checked before allocating for them.
+ */
+uint64_t remainingBytes(std::ifstream& in, uint64_t fileSize)
+{
+    std::streamoff position = in.tellg();
+    return position < 0 || uint64_t(position) > fileSize ? 0 : fileSize - position;
+}
+
+// type and size of the ID, object type, state and container
+const uint64_t MIN_OBJECT_SIZE = 5;
+} // namespace
+
+Checkpoint::Checkpoint()
+        : tick(0)
+        , sizeX(0)
+        , sizeY(0)
+{
+}
+
+bool Checkpoint::write(const std::string& checkpointFile) const
+{
+    std::string tmpFile = checkpointFile + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+        writeValue(out, magic);
+        writeValue(out, version);
+        writeValue(out, this->tick);
+        writeValue(out, this->sizeX);
+        writeValue(out, this->sizeY);
+        writeValue<uint32_t>(out, this->randomState.size());
+        out.write(this->randomState.data(), this->randomState.size());
+        writeValue<uint32_t>(out, this->objects.size());
+        for (const CheckpointObject& object : this->objects) {
+            writeID(out, object.id);
+            writeValue<uint8_t>(out, static_cast<uint8_t>(object.type));
+            writeValue<uint8_t>(out, static_cast<uint8_t>(object.state));
+            writeValue<uint8_t>(out, static_cast<uint8_t>(object.container));
+            if (object.container == CheckpointObject::Container::Cell) {
+                writeValue(out, object.x);
+                writeValue(out, object.y);
+            } else if (object.container == CheckpointObject::Container::Object) {
+                writeID(out, object.parent);
+            }
+        }
+        if (!out) {
+            std::cerr << "[Checkpoint] Unable to write '" << tmpFile << "'!" << std::endl;
+            std::remove(tmpFile.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpFile.c_str(), checkpointFile.c_str()) != 0) {
+        std::cerr << "[Checkpoint] Unable to rename '" << tmpFile << "' to '" << checkpointFile << "'!" << std::endl;
+        std::remove(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::read(const std::string& checkpointFile)
+{
+    std::ifstream in(checkpointFile, std::ios::binary | std::ios::ate);
+    std::streamoff fileSize = in.tellg();
+    in.seekg(0);
+    uint32_t fileMagic = 0;
+    uint32_t fileVersion = 0;
+    if (!readValue(in, fileMagic) || !readValue(in, fileVersion) || fileMagic != magic || fileVersion != version) {
+        std::cerr << "[Checkpoint] '" << checkpointFile << "' is no checkpoint of version " << version << "!" << std::endl;
+        return false;
+    }
+    uint32_t randomStateSize;
+    uint32_t objectCount;
+    if (!readValue(in, this->tick) || !readValue(in, this->sizeX) || !readValue(in, this->sizeY) || !readValue(in, randomStateSize) ||
+            randomStateSize > remainingBytes(in, fileSize)) {
+        std::cerr << "[Checkpoint] '" << checkpointFile << "' is truncated!" << std::endl;
+        return false;
+    }
+    this->randomState.resize(randomStateSize);
+    if (!in.read(&this->randomState[0], randomStateSize) || !readValue(in, objectCount)) {
+        std::cerr << "[Checkpoint] '" << checkpointFile << "' is truncated!" << std::endl;
+        return false;
+    }
+    if (objectCount > remainingBytes(in, fileSize) / MIN_OBJECT_SIZE) {
+        std::cerr << "[Checkpoint] '" << checkpointFile << "' is truncated before " << objectCount << " objects!" << std::endl;
+        return false;
+    }
+
+    this->objects.clear();
+    this->objects.reserve(objectCount);
+    for (uint32_t i = 0; i < objectCount; i++) {
+        CheckpointObject object;
+        uint8_t type;
+        uint8_t state;
+        uint8_t container;
+        bool valid = readID(in, object.id) && readValue(in, type) && readValue(in, state) && readValue(in, container);
+        object.type = static_cast<ObjectType>(type);
+        object.state = static_cast<ObjectState>(state);
+        object.container = static_cast<CheckpointObject::Container>(container);
+        object.x = -1;
+        object.y = -1;
+        if (valid && object.container == CheckpointObject::Container::Cell) {
+            valid = readValue(in, object.x) && readValue(in, object.y);
+        } else if (valid && object.container == CheckpointObject::Container::Object) {
+            valid = readID(in, object.parent);
+        }
+        if (!valid) {
+            std::cerr << "[Checkpoint] '" << checkpointFile << "' is truncated after " << i << " of " << objectCount << " objects!" << std::endl;
+            return false;
+        }
+        this->objects.push_back(std::move(object));
+    }
+    return true;
+}
+} // namespace world
+} // namespace srg
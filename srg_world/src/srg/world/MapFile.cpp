@@ -0,0 +1,285 @@
+#include "srg/world/MapFile.h"
+
+#include <essentials/FileSystem.h>
+
+#include <Tmx.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace srg
+{
+namespace world
+{
+MapFile::MapFile()
+        : data(nullptr)
+        , size(0)
+{
+}
+
+MapFile::~MapFile()
+{
+    this->close();
+}
+
+bool MapFile::open(const std::string& mapFile)
+{
+    this->close();
+    int fd = ::open(mapFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || size_t(fileStat.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "[MapFile] Unable to map '" << mapFile << "'!" << std::endl;
+        return false;
+    }
+    this->data = mapped;
+    this->size = fileStat.st_size;
+
+    const Header& header = this->getHeader();
+    if (header.magic != magic || header.version != version || header.roomsOffset + uint64_t(header.roomCount) * sizeof(RoomRecord) > this->size ||
+            header.cellsOffset + uint64_t(header.sizeX) * header.sizeY * sizeof(CellRecord) > this->size) {
+        std::cerr << "[MapFile] '" << mapFile << "' is not a valid compiled map of version " << version << "!" << std::endl;
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+void MapFile::close()
+{
+    if (this->data) {
+        munmap(this->data, this->size);
+        this->data = nullptr;
+        this->size = 0;
+    }
+}
+
+bool MapFile::isOpen() const
+{
+    return this->data != nullptr;
+}
+
+const MapFile::Header& MapFile::getHeader() const
+{
+    return *static_cast<const Header*>(this->data);
+}
+
+const MapFile::RoomRecord& MapFile::getRoom(uint32_t index) const
+{
+    return reinterpret_cast<const RoomRecord*>(static_cast<const char*>(this->data) + this->getHeader().roomsOffset)[index];
+}
+
+std::string MapFile::getRoomName(uint32_t index) const
+{
+    const RoomRecord& room = this->getRoom(index);
+    const char* names = static_cast<const char*>(this->data) + this->getHeader().namesOffset;
+    if (this->getHeader().namesOffset + room.nameOffset + room.nameLength > this->size) {
+        return "";
+    }
+    return std::string(names + room.nameOffset, room.nameLength);
+}
+
+const MapFile::CellRecord& MapFile::getCell(uint32_t x, uint32_t y) const
+{
+    const Header& header = this->getHeader();
+    return reinterpret_cast<const CellRecord*>(static_cast<const char*>(this->data) + header.cellsOffset)[uint64_t(x) * header.sizeY + y];
+}
+
+bool MapFile::compile(const std::string& tmxFile, const std::string& mapFile)
+{
+    Tmx::Map map;
+    map.ParseFile(tmxFile);
+    if (map.HasError()) {
+        std::cerr << "[MapFile] Unable to parse '" << tmxFile << "': " << map.GetErrorText() << std::endl;
+        return false;
+    }
+    if (map.GetTileLayers().size() >= noRoom) {
+        std::cerr << "[MapFile] '" << tmxFile << "' has more than " << noRoom - 1 << " rooms!" << std::endl;
+        return false;
+    }
+
+    uint32_t sizeX = 0;
+    uint32_t sizeY = 0;
+    for (auto layer : map.GetTileLayers()) {
+        for (int x = 0; x < layer->GetWidth(); x++) {
+            for (int y = 0; y < layer->GetHeight(); y++) {
+                if (layer->GetTile(x, y).gid > 0) {
+                    sizeX = std::max(sizeX, uint32_t(x + 1));
+                    sizeY = std::max(sizeY, uint32_t(y + 1));
+                }
+            }
+        }
+    }
+
+    // same semantics as parsing the TMX file directly: the first room containing a cell owns it,
+    // the type of a room is given by its last tile
+    std::vector<RoomRecord> rooms;
+    std::string names;
+    CellRecord empty = {noRoom, 0, 0};
+    std::vector<CellRecord> cells(size_t(sizeX) * sizeY, empty);
+    for (auto layer : map.GetTileLayers()) {
+        RoomRecord room = RoomRecord();
+        room.id = layer->GetProperties().GetIntProperty("ID");
+        room.nameOffset = names.size();
+        room.nameLength = layer->GetName().size();
+        names += layer->GetName();
+        int roomType = 0;
+        for (int x = 0; x < layer->GetWidth(); x++) {
+            for (int y = 0; y < layer->GetHeight(); y++) {
+                if (layer->GetTile(x, y).gid > 0) {
+                    roomType = layer->GetTile(x, y).gid - 17;
+                    CellRecord& cell = cells[size_t(x) * sizeY + y];
+                    if (cell.room == noRoom) {
+                        cell.room = rooms.size();
+                    }
+                }
+            }
+        }
+        room.type = static_cast<uint32_t>(roomType);
+        rooms.push_back(room);
+    }
+    return MapFile::write(mapFile, MapFile::hashFile(tmxFile), sizeX, sizeY, rooms, names, cells);
+}
+
+bool MapFile::write(const std::string& mapFile, uint64_t sourceHash, uint32_t sizeX, uint32_t sizeY, const std::vector<RoomRecord>& rooms,
+        const std::string& names, std::vector<CellRecord>& cells)
+{
+    if (rooms.size() >= noRoom || cells.size() != size_t(sizeX) * sizeY) {
+        std::cerr << "[MapFile] Invalid map for '" << mapFile << "': " << rooms.size() << " rooms, " << cells.size() << " cells!" << std::endl;
+        return false;
+    }
+    Header header = Header();
+    header.magic = magic;
+    header.version = version;
+    header.sourceHash = sourceHash;
+    header.sizeX = sizeX;
+    header.sizeY = sizeY;
+    header.roomCount = rooms.size();
+    for (uint32_t x = 0; x < header.sizeX; x++) {
+        for (uint32_t y = 0; y < header.sizeY; y++) {
+            CellRecord& cell = cells[size_t(x) * header.sizeY + y];
+            if (cell.room == noRoom) {
+                continue;
+            }
+            header.cellCount++;
+            cell.flags = 0;
+            cell.type = rooms[cell.room].type;
+            if (static_cast<RoomType>(rooms[cell.room].type) != RoomType::Wall) {
+                cell.flags |= Passable;
+            }
+            if (x > 0 && cells[size_t(x - 1) * header.sizeY + y].room != noRoom) {
+                cell.flags |= LeftNeighbour;
+            }
+            if (y > 0 && cells[size_t(x) * header.sizeY + y - 1].room != noRoom) {
+                cell.flags |= UpNeighbour;
+            }
+            if (x + 1 < header.sizeX && cells[size_t(x + 1) * header.sizeY + y].room != noRoom) {
+                cell.flags |= RightNeighbour;
+            }
+            if (y + 1 < header.sizeY && cells[size_t(x) * header.sizeY + y + 1].room != noRoom) {
+                cell.flags |= DownNeighbour;
+            }
+        }
+    }
+
+    header.roomsOffset = sizeof(Header);
+    header.namesOffset = header.roomsOffset + rooms.size() * sizeof(RoomRecord);
+    // keep the cells aligned
+    header.cellsOffset = (header.namesOffset + names.size() + 7) & ~uint64_t(7);
+
+    // written to a temporary file and renamed, so concurrent readers never see a partial map
+    std::string tmpFile = mapFile + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        out.write(reinterpret_cast<const char*>(rooms.data()), rooms.size() * sizeof(RoomRecord));
+        out.write(names.data(), names.size());
+        std::vector<char> padding(header.cellsOffset - header.namesOffset - names.size(), 0);
+        out.write(padding.data(), padding.size());
+        out.write(reinterpret_cast<const char*>(cells.data()), cells.size() * sizeof(CellRecord));
+        if (!out) {
+            std::cerr << "[MapFile] Unable to write '" << tmpFile << "'!" << std::endl;
+            std::remove(tmpFile.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpFile.c_str(), mapFile.c_str()) != 0) {
+        std::cerr << "[MapFile] Unable to rename '" << tmpFile << "' to '" << mapFile << "'!" << std::endl;
+        std::remove(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string MapFile::findOrCompile(const std::string& tmxFile)
+{
+    char* homeFolder = getenv("HOME");
+    if (homeFolder == NULL) {
+        return "";
+    }
+    uint64_t hash = MapFile::hashFile(tmxFile);
+    if (hash == 0) {
+        return "";
+    }
+    std::string cacheFolder = essentials::FileSystem::combinePaths(std::string(homeFolder), ".grid_sim");
+    if (!essentials::FileSystem::pathExists(cacheFolder)) {
+        essentials::FileSystem::createDirectory(cacheFolder, 755);
+    }
+    cacheFolder = essentials::FileSystem::combinePaths(cacheFolder, "maps");
+    if (!essentials::FileSystem::pathExists(cacheFolder)) {
+        essentials::FileSystem::createDirectory(cacheFolder, 755);
+    }
+
+    std::string name = tmxFile.substr(tmxFile.find_last_of('/') + 1);
+    name = name.substr(0, name.find_last_of('.'));
+    char hashString[17];
+    snprintf(hashString, sizeof(hashString), "%016llx", static_cast<unsigned long long>(hash));
+    std::string mapFile = essentials::FileSystem::combinePaths(cacheFolder, name + "-" + hashString + ".srgmap");
+    if (essentials::FileSystem::pathExists(mapFile)) {
+        return mapFile;
+    }
+    std::cout << "[MapFile] Compiling '" << tmxFile << "' to '" << mapFile << "'" << std::endl;
+    if (!MapFile::compile(tmxFile, mapFile)) {
+        return "";
+    }
+    return mapFile;
+}
+
+/**
+ * FNV-1a of the file content, 0 if the file can't be read.
+ */
+uint64_t MapFile::hashFile(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        return 0;
+    }
+    uint64_t hash = 14695981039346656037ull;
+    char buffer[65536];
+    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+        for (std::streamsize i = 0; i < in.gcount(); i++) {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+} // namespace world
+} // namespace srg
@@ -95,7 +95,10 @@ ObjectType Object::getType() const
 
 void Object::setType(ObjectType type)
 {
-    this->type = type;
+    if (this->type != type) {
+        this->type = type;
+        this->markChanged();
+    }
 }
 
 ObjectState Object::getState() const
@@ -105,7 +108,17 @@ ObjectState Object::getState() const
 
 void Object::setState(ObjectState state)
 {
-    this->state = state;
+    if (this->state != state) {
+        this->state = state;
+        this->markChanged();
+    }
+}
+
+void Object::markChanged()
+{
+    if (this->parentContainer) {
+        this->parentContainer->markChanged();
+    }
 }
 
 essentials::IdentifierConstPtr Object::getID() const
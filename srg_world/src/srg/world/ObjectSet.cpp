@@ -33,6 +33,7 @@ bool ObjectSet::addObject(std::shared_ptr<world::Object> object)
     if (this->containingObjects.size() < capacity) {
         if (this->containingObjects.insert({object->getID(), object}).second) {
             object->setParentContainer(this->shared_from_this());
+            this->markChanged();
             return true;
         }
     }
@@ -43,14 +44,18 @@ void ObjectSet::removeObject(std::shared_ptr<world::Object> object)
 {
     if (this->containingObjects.erase(object->getID()) > 0) {
         object->deleteParentContainer();
+        this->markChanged();
     }
 }
 
 std::unordered_map<essentials::IdentifierConstPtr, std::shared_ptr<world::Object>>::iterator ObjectSet::removeObject(
         std::unordered_map<essentials::IdentifierConstPtr, std::shared_ptr<world::Object>>::iterator iter)
 {
+    // the iterator is invalid after erasing
+    std::shared_ptr<world::Object> object = iter->second;
     std::unordered_map<essentials::IdentifierConstPtr, std::shared_ptr<world::Object>>::iterator iterator = this->containingObjects.erase(iter);
-    iter->second->deleteParentContainer();
+    object->deleteParentContainer();
+    this->markChanged();
     return iterator;
 }
 
@@ -86,6 +91,8 @@ void ObjectSet::update(std::vector<std::shared_ptr<world::Object>> updateObjects
     }
 }
 
+void ObjectSet::markChanged() {}
+
 std::ostream& operator<<(std::ostream& os, const ObjectSet& objectSet)
 {
     for (auto& objectEntry : objectSet.containingObjects) {
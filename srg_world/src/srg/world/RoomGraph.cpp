@@ -0,0 +1,360 @@
+#include "srg/world/RoomGraph.h"
+
+#include "srg/world/Cell.h"
+#include "srg/world/Object.h"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+
+namespace srg
+{
+namespace world
+{
+namespace
+{
+/**
+ * Breadth-first search arrays of one thread, reused over its traversals of any graph. Cells are only
+ * visited if their stamp matches the current traversal, so nothing has to be cleared in between.
+ */
+struct TraversalSpace
+{
+    TraversalSpace()
+            : visit(0)
+    {
+    }
+
+    void begin(size_t cellCount)
+    {
+        if (this->visited.size() < cellCount) {
+            this->visited.resize(cellCount, 0);
+            this->cellCosts.resize(cellCount);
+        }
+        if (++this->visit == 0) {
+            std::fill(this->visited.begin(), this->visited.end(), 0);
+            this->visit = 1;
+        }
+        this->queue.clear();
+    }
+
+    std::vector<uint32_t> visited;
+    std::vector<uint32_t> cellCosts;
+    std::vector<uint32_t> queue;
+    uint32_t visit;
+};
+} // namespace
+
+const uint32_t RoomGraph::unreachable;
+
+RoomGraph::RoomGraph()
+        : sizeX(0)
+        , sizeY(0)
+        , doorCount(0)
+{
+}
+
+void RoomGraph::build(const std::map<Coordinate, std::shared_ptr<Cell>>& grid, uint32_t sizeX, uint32_t sizeY)
+{
+    this->sizeX = sizeX;
+    this->sizeY = sizeY;
+    size_t cellCount = size_t(sizeX) * sizeY;
+    this->cellRooms.assign(cellCount, -1);
+    this->cellPortals.assign(cellCount, -1);
+    this->roomNodes.clear();
+    this->portals.clear();
+    this->doorPortals.clear();
+    this->doorCount = 0;
+
+    // rooms
+    std::unordered_map<Room*, uint32_t> roomIndices;
+    for (auto& cellEntry : grid) {
+        const Coordinate& coordinate = cellEntry.first;
+        if (coordinate.x < 0 || coordinate.y < 0 || uint32_t(coordinate.x) >= sizeX || uint32_t(coordinate.y) >= sizeY ||
+                cellEntry.second->getType() == RoomType::Wall || !cellEntry.second->room) {
+            continue;
+        }
+        auto roomEntry = roomIndices.emplace(cellEntry.second->room, this->roomNodes.size());
+        if (roomEntry.second) {
+            this->roomNodes.push_back({cellEntry.second->room, {}, {}});
+        }
+        this->cellRooms[uint32_t(coordinate.x) * sizeY + coordinate.y] = roomEntry.first->second;
+    }
+
+    // doors connect the room of their cell with the rooms next to it
+    uint32_t neighbours[4];
+    for (auto& cellEntry : grid) {
+        for (auto& objectEntry : cellEntry.second->getObjects()) {
+            if (objectEntry.second->getType() != ObjectType::Door) {
+                continue;
+            }
+            const Coordinate& coordinate = cellEntry.first;
+            if (coordinate.x < 0 || coordinate.y < 0 || uint32_t(coordinate.x) >= sizeX || uint32_t(coordinate.y) >= sizeY) {
+                continue;
+            }
+            uint32_t cell = uint32_t(coordinate.x) * sizeY + coordinate.y;
+            if (this->cellRooms[cell] < 0 || this->cellPortals[cell] >= 0) {
+                continue;
+            }
+            Portal portal = {objectEntry.first, cell, {uint32_t(this->cellRooms[cell])}, objectEntry.second->getState() == ObjectState::Open};
+            for (uint32_t i = 0, count = this->collectNeighbours(cell, neighbours); i < count; i++) {
+                int32_t room = this->cellRooms[neighbours[i]];
+                if (room >= 0 && std::find(portal.rooms.begin(), portal.rooms.end(), uint32_t(room)) == portal.rooms.end()) {
+                    portal.rooms.push_back(room);
+                }
+            }
+            this->cellPortals[cell] = this->portals.size();
+            this->doorPortals[portal.doorID] = this->portals.size();
+            this->portals.push_back(portal);
+            this->doorCount++;
+        }
+    }
+
+    // rooms bordering each other without a door get one passage
+    std::set<std::pair<uint32_t, uint32_t>> passages;
+    for (uint32_t cell = 0; cell < cellCount; cell++) {
+        int32_t room = this->cellRooms[cell];
+        if (room < 0 || this->cellPortals[cell] >= 0) {
+            continue;
+        }
+        for (uint32_t i = 0, count = this->collectNeighbours(cell, neighbours); i < count; i++) {
+            uint32_t neighbour = neighbours[i];
+            int32_t otherRoom = this->cellRooms[neighbour];
+            if (otherRoom < 0 || otherRoom == room || (this->cellPortals[neighbour] >= 0 && this->portals[this->cellPortals[neighbour]].doorID)) {
+                continue;
+            }
+            if (!passages.insert(std::make_pair(std::min(room, otherRoom), std::max(room, otherRoom))).second) {
+                continue;
+            }
+            this->cellPortals[cell] = this->portals.size();
+            this->portals.push_back({nullptr, cell, {uint32_t(room), uint32_t(otherRoom)}, true});
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < this->portals.size(); i++) {
+        for (uint32_t room : this->portals[i].rooms) {
+            this->roomNodes[room].portals.push_back(i);
+        }
+    }
+
+    // traversal costs between the portals of each room
+    std::vector<uint32_t> portalCosts;
+    uint32_t ignored;
+    for (uint32_t room = 0; room < this->roomNodes.size(); room++) {
+        RoomNode& node = this->roomNodes[room];
+        size_t count = node.portals.size();
+        node.costs.assign(count * count, unreachable);
+        for (size_t i = 0; i < count; i++) {
+            this->traverse(room, this->portals[node.portals[i]].cell, portalCosts, unreachable, ignored);
+            std::copy(portalCosts.begin(), portalCosts.end(), node.costs.begin() + i * count);
+        }
+    }
+}
+
+bool RoomGraph::setDoorOpen(essentials::IdentifierConstPtr doorID, bool open)
+{
+    auto portalEntry = this->doorPortals.find(doorID);
+    if (portalEntry == this->doorPortals.end()) {
+        return false;
+    }
+    this->portals[portalEntry->second].open = open;
+    return true;
+}
+
+bool RoomGraph::findRoute(const Coordinate& from, const Coordinate& to, std::vector<Coordinate>& waypoints, uint32_t& cost, uint32_t& expansions) const
+{
+    waypoints.clear();
+    cost = 0;
+    expansions = 0;
+    if (from.x < 0 || from.y < 0 || to.x < 0 || to.y < 0 || uint32_t(from.x) >= this->sizeX || uint32_t(from.y) >= this->sizeY ||
+            uint32_t(to.x) >= this->sizeX || uint32_t(to.y) >= this->sizeY) {
+        return false;
+    }
+    uint32_t start = uint32_t(from.x) * this->sizeY + from.y;
+    uint32_t goal = uint32_t(to.x) * this->sizeY + to.y;
+    int32_t startRoom = this->cellRooms[start];
+    int32_t goalRoom = this->cellRooms[goal];
+    if (startRoom < 0 || goalRoom < 0) {
+        return false;
+    }
+
+    // start and goal are temporarily connected to the portals of their rooms
+    std::vector<uint32_t> startCosts;
+    std::vector<uint32_t> goalCosts;
+    uint32_t direct;
+    this->traverse(startRoom, start, startCosts, goal, direct);
+    if (direct != unreachable) {
+        waypoints.push_back(from);
+        waypoints.push_back(to);
+        cost = direct;
+        return true;
+    }
+    this->traverse(goalRoom, goal, goalCosts, unreachable, direct);
+
+    // A* over the portals, the goal is the node after the last portal
+    uint32_t goalNode = this->portals.size();
+    std::vector<uint32_t> costs(goalNode + 1, unreachable);
+    std::vector<uint32_t> parents(goalNode + 1, unreachable);
+    std::vector<bool> closed(goalNode + 1, false);
+    std::vector<std::pair<uint32_t, uint32_t>> open;
+    auto push = [&](uint32_t node, uint32_t nodeCost, uint32_t parent) {
+        if (nodeCost >= costs[node]) {
+            return;
+        }
+        costs[node] = nodeCost;
+        parents[node] = parent;
+        open.emplace_back(nodeCost + (node == goalNode ? 0 : this->distance(this->portals[node].cell, goal)), node);
+        std::push_heap(open.begin(), open.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+    };
+
+    const RoomNode& startNode = this->roomNodes[startRoom];
+    for (size_t i = 0; i < startNode.portals.size(); i++) {
+        if (startCosts[i] != unreachable && this->portals[startNode.portals[i]].open) {
+            push(startNode.portals[i], startCosts[i], unreachable);
+        }
+    }
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+        uint32_t node = open.back().second;
+        open.pop_back();
+        if (closed[node]) {
+            continue;
+        }
+        closed[node] = true;
+        if (node == goalNode) {
+            break;
+        }
+        expansions++;
+
+        if (this->cellPortals[goal] == int32_t(node)) {
+            push(goalNode, costs[node], node);
+        }
+        for (uint32_t room : this->portals[node].rooms) {
+            const RoomNode& roomNode = this->roomNodes[room];
+            size_t count = roomNode.portals.size();
+            size_t i = this->findRoomPortal(room, node);
+            for (size_t j = 0; j < count; j++) {
+                uint32_t step = roomNode.costs[i * count + j];
+                uint32_t portal = roomNode.portals[j];
+                if (step != unreachable && !closed[portal] && this->portals[portal].open) {
+                    push(portal, costs[node] + step, node);
+                }
+            }
+            if (int32_t(room) == goalRoom && goalCosts[i] != unreachable) {
+                push(goalNode, costs[node] + goalCosts[i], node);
+            }
+        }
+    }
+    if (!closed[goalNode]) {
+        return false;
+    }
+
+    cost = costs[goalNode];
+    waypoints.push_back(to);
+    for (uint32_t node = parents[goalNode]; node != unreachable; node = parents[node]) {
+        waypoints.push_back(Coordinate(this->portals[node].cell / this->sizeY, this->portals[node].cell % this->sizeY));
+    }
+    waypoints.push_back(from);
+    std::reverse(waypoints.begin(), waypoints.end());
+    return true;
+}
+
+void RoomGraph::traverse(uint32_t roomNode, uint32_t startCell, std::vector<uint32_t>& portalCosts, uint32_t targetCell, uint32_t& targetCost) const
+{
+    static thread_local TraversalSpace space;
+    space.begin(this->cellRooms.size());
+    portalCosts.assign(this->roomNodes[roomNode].portals.size(), unreachable);
+    targetCost = startCell == targetCell ? 0 : unreachable;
+    space.visited[startCell] = space.visit;
+    space.cellCosts[startCell] = 0;
+    if (this->cellPortals[startCell] >= 0) {
+        int32_t slot = this->findRoomPortal(roomNode, this->cellPortals[startCell]);
+        if (slot >= 0) {
+            portalCosts[slot] = 0;
+        }
+    }
+
+    space.queue.push_back(startCell);
+    uint32_t neighbours[4];
+    for (size_t head = 0; head < space.queue.size(); head++) {
+        uint32_t cell = space.queue[head];
+        uint32_t cost = space.cellCosts[cell] + 1;
+        for (uint32_t i = 0, count = this->collectNeighbours(cell, neighbours); i < count; i++) {
+            uint32_t neighbour = neighbours[i];
+            if (space.visited[neighbour] == space.visit) {
+                continue;
+            }
+            bool inRoom = this->cellRooms[neighbour] == int32_t(roomNode);
+            int32_t portal = this->cellPortals[neighbour];
+            int32_t slot = portal >= 0 ? this->findRoomPortal(roomNode, portal) : -1;
+            if (!inRoom && slot < 0) {
+                continue;
+            }
+            space.visited[neighbour] = space.visit;
+            space.cellCosts[neighbour] = cost;
+            if (slot >= 0 && portalCosts[slot] == unreachable) {
+                portalCosts[slot] = cost;
+            }
+            if (neighbour == targetCell) {
+                targetCost = cost;
+            }
+            // doors and portal cells of other rooms are only entered, paths through them belong to the next room
+            if (inRoom && (portal < 0 || !this->portals[portal].doorID)) {
+                space.queue.push_back(neighbour);
+            }
+        }
+    }
+}
+
+uint32_t RoomGraph::collectNeighbours(uint32_t cell, uint32_t (&neighbours)[4]) const
+{
+    uint32_t x = cell / this->sizeY;
+    uint32_t y = cell % this->sizeY;
+    uint32_t count = 0;
+    if (x > 0) {
+        neighbours[count++] = cell - this->sizeY;
+    }
+    if (x + 1 < this->sizeX) {
+        neighbours[count++] = cell + this->sizeY;
+    }
+    if (y > 0) {
+        neighbours[count++] = cell - 1;
+    }
+    if (y + 1 < this->sizeY) {
+        neighbours[count++] = cell + 1;
+    }
+    return count;
+}
+
+int32_t RoomGraph::findRoomPortal(uint32_t roomNode, uint32_t portal) const
+{
+    const std::vector<uint32_t>& roomPortals = this->roomNodes[roomNode].portals;
+    auto portalEntry = std::find(roomPortals.begin(), roomPortals.end(), portal);
+    return portalEntry == roomPortals.end() ? -1 : int32_t(portalEntry - roomPortals.begin());
+}
+
+uint32_t RoomGraph::distance(uint32_t cell, uint32_t otherCell) const
+{
+    uint32_t x = cell / this->sizeY;
+    uint32_t y = cell % this->sizeY;
+    uint32_t otherX = otherCell / this->sizeY;
+    uint32_t otherY = otherCell % this->sizeY;
+    return (x > otherX ? x - otherX : otherX - x) + (y > otherY ? y - otherY : otherY - y);
+}
+
+uint32_t RoomGraph::getRoomCount() const
+{
+    return this->roomNodes.size();
+}
+
+uint32_t RoomGraph::getPortalCount() const
+{
+    return this->portals.size();
+}
+
+uint32_t RoomGraph::getDoorCount() const
+{
+    return this->doorCount;
+}
+} // namespace world
+} // namespace srg
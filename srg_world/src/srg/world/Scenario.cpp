@@ -0,0 +1,185 @@
+#include "srg/world/Scenario.h"
+
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+namespace srg
+{
+namespace world
+{
+Scenario::Scenario()
+        : errorCount(0)
+{
+}
+
+bool Scenario::load(const std::string& scenarioFile)
+{
+    std::ifstream in(scenarioFile);
+    if (!in) {
+        std::cerr << "[Scenario] Unable to read '" << scenarioFile << "'!" << std::endl;
+        return false;
+    }
+    this->objects.clear();
+    this->errorCount = 0;
+    std::unordered_set<int32_t> ids;
+    std::string line;
+    std::string fields; // reused, split in place by parseLine
+    uint32_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        ScenarioObject object;
+        fields.assign(line, start, std::string::npos);
+        if (!this->parseLine(&fields[0], object)) {
+            this->reportError(lineNumber, "expected <id>,<door|cup_red|cup_blue|cup_yellow>,<x>,<y>[,<open|closed>] but got '" + line + "'");
+            continue;
+        }
+        if (!ids.insert(object.id).second) {
+            this->reportError(lineNumber, "duplicate ID " + std::to_string(object.id));
+            continue;
+        }
+        this->objects.push_back(object);
+    }
+    if (this->errorCount > 0) {
+        std::cerr << "[Scenario] Skipped " << this->errorCount << " invalid lines of '" << scenarioFile << "'" << std::endl;
+    }
+    return true;
+}
+
+/**
+ * Splits the line in place, so no strings are allocated per object.
+ */
+bool Scenario::parseLine(char* line, ScenarioObject& object) const
+{
+    char* fields[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
+    int fieldCount = 0;
+    for (char* field = line; field && fieldCount < 5; fieldCount++) {
+        fields[fieldCount] = field;
+        field = strchr(field, ',');
+        if (field) {
+            *field++ = '\0';
+        }
+    }
+    if (fieldCount < 4) {
+        return false;
+    }
+    // trailing whitespace and carriage returns of the last field
+    char* last = fields[fieldCount - 1];
+    for (size_t length = strlen(last); length > 0 && isspace(static_cast<unsigned char>(last[length - 1])); length--) {
+        last[length - 1] = '\0';
+    }
+
+    long values[3];
+    const int numericFields[3] = {0, 2, 3};
+    for (int i = 0; i < 3; i++) {
+        char* end;
+        errno = 0;
+        values[i] = strtol(fields[numericFields[i]], &end, 10);
+        if (end == fields[numericFields[i]] || *end != '\0' || errno != 0 || values[i] < INT_MIN || values[i] > INT_MAX) {
+            return false;
+        }
+    }
+    if (!Scenario::parseType(fields[1], object.type)) {
+        return false;
+    }
+    object.id = values[0];
+    object.x = values[1];
+    object.y = values[2];
+
+    object.state = ObjectState::Undefined;
+    if (fieldCount == 5 && strcmp(fields[4], "open") == 0) {
+        object.state = ObjectState::Open;
+    } else if (fieldCount == 5 && strcmp(fields[4], "closed") == 0) {
+        object.state = ObjectState::Closed;
+    } else if (fieldCount == 5 && fields[4][0] != '\0') {
+        return false;
+    }
+    return object.type != ObjectType::Door || object.state != ObjectState::Undefined;
+}
+
+void Scenario::reportError(uint32_t lineNumber, const std::string& message)
+{
+    // the first errors are enough to fix a generator
+    if (this->errorCount++ < 10) {
+        std::cerr << "[Scenario] Line " << lineNumber << ": " << message << std::endl;
+    }
+}
+
+bool Scenario::write(const std::string& scenarioFile) const
+{
+    std::ofstream out(scenarioFile, std::ios::trunc);
+    out << "# id,type,x,y,state" << std::endl;
+    for (const ScenarioObject& object : this->objects) {
+        out << object.id << ',' << Scenario::toString(object.type) << ',' << object.x << ',' << object.y;
+        if (object.state == ObjectState::Open) {
+            out << ",open";
+        } else if (object.state == ObjectState::Closed) {
+            out << ",closed";
+        }
+        out << '\n';
+    }
+    if (!out) {
+        std::cerr << "[Scenario] Unable to write '" << scenarioFile << "'!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Scenario::addObject(const ScenarioObject& object)
+{
+    this->objects.push_back(object);
+}
+
+const std::vector<ScenarioObject>& Scenario::getObjects() const
+{
+    return this->objects;
+}
+
+uint32_t Scenario::getErrorCount() const
+{
+    return this->errorCount;
+}
+
+bool Scenario::parseType(const char* type, ObjectType& objectType)
+{
+    if (strcmp(type, "cup_blue") == 0) {
+        objectType = ObjectType::CupBlue;
+    } else if (strcmp(type, "cup_red") == 0) {
+        objectType = ObjectType::CupRed;
+    } else if (strcmp(type, "cup_yellow") == 0) {
+        objectType = ObjectType::CupYellow;
+    } else if (strcmp(type, "door") == 0) {
+        objectType = ObjectType::Door;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Scenario::toString(ObjectType type)
+{
+    switch (type) {
+    case ObjectType::CupBlue:
+        return "cup_blue";
+    case ObjectType::CupRed:
+        return "cup_red";
+    case ObjectType::CupYellow:
+        return "cup_yellow";
+    case ObjectType::Door:
+        return "door";
+    default:
+        return "unknown";
+    }
+}
+} // namespace world
+} // namespace srg